@@ -0,0 +1,732 @@
+/*
+ * Adaptive radix tree
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/art.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Children are tagged pointers, the low bit set is a leaf. Node4 and node16
+ * keep their key bytes sorted, node48 and node256 are indexed by the byte,
+ * so every node is visited in key order. Nodes grow when full and shrink 
+ * at 3, 12 and 37 children, a node4 left with a single child is merged 
+ * into it, one left with the leaf only is replaced by the leaf.
+ */
+
+static const size_t art_node_size[] = {
+	[ART_NODE4]   = sizeof(struct art_node4),
+	[ART_NODE16]  = sizeof(struct art_node16),
+	[ART_NODE48]  = sizeof(struct art_node48),
+	[ART_NODE256] = sizeof(struct art_node256),
+};
+
+static inline int
+art_is_leaf(const void *ptr)
+{
+	return (uintptr_t)ptr & 1;
+}
+
+static inline struct art_leaf *
+art_leaf(const void *ptr)
+{
+	return (struct art_leaf *)((uintptr_t)ptr & ~(uintptr_t)1);
+}
+
+static inline void *
+art_leaf_tag(struct art_leaf *leaf)
+{
+	return (void *)((uintptr_t)leaf | 1);
+}
+
+static inline int
+art_leaf_eq(const struct art_leaf *leaf, const u8 *key, size_t len)
+{
+	return leaf->len == len && !memcmp(leaf->key, key, len);
+}
+
+/*
+ * Sizes are rounded with align_addr(), allocators like mm_pool() do not 
+ * align and the low bit of every leaf and node address must stay clear.
+ */
+
+static struct art_leaf *
+art_leaf_new(struct art *art, const u8 *key, size_t len, void *val)
+{
+	size_t size = align_addr(sizeof(struct art_leaf) + len);
+	struct art_leaf *leaf = mm_alloc(art->mm, size);
+	leaf->val = val;
+	leaf->len = len;
+	memcpy(leaf->key, key, len);
+	return leaf;
+}
+
+static void
+art_leaf_free(struct art *art, struct art_leaf *leaf, void **val)
+{
+	if (val)
+		*val = leaf->val;
+	mm_free(art->mm, leaf);
+}
+
+static struct art_node *
+art_node_new(struct art *art, u8 type)
+{
+	size_t size = align_addr(art_node_size[type]);
+	struct art_node *node = mm_zalloc(art->mm, size);
+	node->type = type;
+	return node;
+}
+
+/* moves the header into a node of another type and frees the old one */
+static struct art_node *
+art_node_move(struct art *art, struct art_node *node, u8 type)
+{
+	struct art_node *moved = art_node_new(art, type);
+	moved->count = node->count;
+	moved->prefix_len = node->prefix_len;
+	memcpy(moved->prefix, node->prefix, sizeof(node->prefix));
+	moved->leaf = node->leaf;
+	return moved;
+}
+
+/* number of key bytes less than byte */
+static inline unsigned int
+art_node16_rank(const struct art_node16 *n, u8 byte)
+{
+#ifdef __SSE2__
+	const __m128i bias = _mm_set1_epi8((char)0x80);
+	__m128i key = _mm_xor_si128(_mm_loadu_si128((const __m128i *)n->key), bias);
+	__m128i lt = _mm_cmplt_epi8(key, 
+	                            _mm_xor_si128(_mm_set1_epi8((char)byte), bias));
+	unsigned int mask = _mm_movemask_epi8(lt) & ((1U << n->node.count) - 1);
+	return __builtin_popcount(mask);
+#else
+	unsigned int pos = 0;
+	while (pos < n->node.count && n->key[pos] < byte)
+		pos++;
+	return pos;
+#endif
+}
+
+static void **
+art_child(struct art_node *node, u8 byte)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		for (unsigned int i = 0; i < node->count; i++)
+			if (n->key[i] == byte)
+				return &n->child[i];
+		return NULL;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+#ifdef __SSE2__
+		__m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), 
+		                            _mm_loadu_si128((__m128i *)n->key));
+		unsigned int mask = _mm_movemask_epi8(eq) & ((1U << node->count) - 1);
+		return mask ? &n->child[__builtin_ctz(mask)]: NULL;
+#else
+		for (unsigned int i = 0; i < node->count; i++)
+			if (n->key[i] == byte)
+				return &n->child[i];
+		return NULL;
+#endif
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		return n->index[byte] ? &n->child[n->index[byte] - 1]: NULL;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		return n->child[byte] ? &n->child[byte]: NULL;
+	}
+	}
+	return NULL;
+}
+
+/* leftmost leaf, any leaf below a node holds its whole prefix */
+static const struct art_leaf *
+art_minimum(const void *ptr)
+{
+	while (!art_is_leaf(ptr)) {
+		const struct art_node *node = ptr;
+		unsigned int b = 0;
+		if (node->leaf)
+			return node->leaf;
+		switch (node->type) {
+		case ART_NODE4:
+			ptr = ((const struct art_node4 *)node)->child[0];
+			break;
+		case ART_NODE16:
+			ptr = ((const struct art_node16 *)node)->child[0];
+			break;
+		case ART_NODE48: {
+			const struct art_node48 *n = (const struct art_node48 *)node;
+			while (!n->index[b])
+				b++;
+			ptr = n->child[n->index[b] - 1];
+			break;
+		}
+		case ART_NODE256: {
+			const struct art_node256 *n = (const struct art_node256 *)node;
+			while (!n->child[b])
+				b++;
+			ptr = n->child[b];
+			break;
+		}
+		}
+	}
+	return art_leaf(ptr);
+}
+
+/* stored prefix bytes matching the key, depth + prefix_len <= len */
+static inline unsigned int
+art_check_prefix(const struct art_node *node, const u8 *key, size_t depth)
+{
+	unsigned int max = __min(node->prefix_len, ART_PREFIX), i;
+	for (i = 0; i < max; i++)
+		if (node->prefix[i] != key[depth + i])
+			break;
+	return i;
+}
+
+/* whole prefix bytes matching the key, depth <= len */
+static size_t
+art_prefix_mismatch(const struct art_node *node, const u8 *key, size_t len,
+                    size_t depth)
+{
+	size_t max = __min((size_t)node->prefix_len, len - depth), i;
+	for (i = 0; i < __min(max, (size_t)ART_PREFIX); i++)
+		if (node->prefix[i] != key[depth + i])
+			return i;
+	if (i < max) {
+		const struct art_leaf *leaf = art_minimum(node);
+		for (; i < max; i++)
+			if (leaf->key[depth + i] != key[depth + i])
+				return i;
+	}
+	return i;
+}
+
+static void
+art_add_child(struct art *art, void **ref, struct art_node *node, u8 byte,
+              void *child)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		if (node->count < 4) {
+			unsigned int pos = 0;
+			while (pos < node->count && n->key[pos] < byte)
+				pos++;
+			memmove(n->key + pos + 1, n->key + pos, node->count - pos);
+			memmove(n->child + pos + 1, n->child + pos, 
+			        (node->count - pos) * sizeof(void *));
+			n->key[pos] = byte;
+			n->child[pos] = child;
+			node->count++;
+			return;
+		}
+		struct art_node16 *grown = (struct art_node16 *)
+			art_node_move(art, node, ART_NODE16);
+		memcpy(grown->key, n->key, 4);
+		memcpy(grown->child, n->child, 4 * sizeof(void *));
+		mm_free(art->mm, node);
+		*ref = grown;
+		art_add_child(art, ref, &grown->node, byte, child);
+		return;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		if (node->count < 16) {
+			unsigned int pos = art_node16_rank(n, byte);
+			memmove(n->key + pos + 1, n->key + pos, node->count - pos);
+			memmove(n->child + pos + 1, n->child + pos, 
+			        (node->count - pos) * sizeof(void *));
+			n->key[pos] = byte;
+			n->child[pos] = child;
+			node->count++;
+			return;
+		}
+		struct art_node48 *grown = (struct art_node48 *)
+			art_node_move(art, node, ART_NODE48);
+		for (unsigned int i = 0; i < 16; i++) {
+			grown->index[n->key[i]] = i + 1;
+			grown->child[i] = n->child[i];
+		}
+		mm_free(art->mm, node);
+		*ref = grown;
+		art_add_child(art, ref, &grown->node, byte, child);
+		return;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		if (node->count < 48) {
+			unsigned int pos = 0;
+			while (n->child[pos])
+				pos++;
+			n->child[pos] = child;
+			n->index[byte] = pos + 1;
+			node->count++;
+			return;
+		}
+		struct art_node256 *grown = (struct art_node256 *)
+			art_node_move(art, node, ART_NODE256);
+		for (unsigned int b = 0; b < 256; b++)
+			if (n->index[b])
+				grown->child[b] = n->child[n->index[b] - 1];
+		mm_free(art->mm, node);
+		*ref = grown;
+		art_add_child(art, ref, &grown->node, byte, child);
+		return;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		n->child[byte] = child;
+		node->count++;
+		return;
+	}
+	}
+}
+
+/* a node4 with a single child or with the leaf only goes away */
+static void
+art_collapse(struct art *art, void **ref, struct art_node *node)
+{
+	struct art_node4 *n = (struct art_node4 *)node;
+	if (node->count == 0) {
+		*ref = node->leaf ? art_leaf_tag(node->leaf): NULL;
+		mm_free(art->mm, node);
+		return;
+	}
+	if (node->count > 1 || node->leaf)
+		return;
+
+	void *child = n->child[0];
+	if (!art_is_leaf(child)) {
+		struct art_node *c = child;
+		unsigned int len = node->prefix_len;
+		if (len < ART_PREFIX)
+			node->prefix[len++] = n->key[0];
+		if (len < ART_PREFIX) {
+			unsigned int sub = __min(c->prefix_len, ART_PREFIX - len);
+			memcpy(node->prefix + len, c->prefix, sub);
+			len += sub;
+		}
+		memcpy(c->prefix, node->prefix, __min(len, ART_PREFIX));
+		c->prefix_len += node->prefix_len + 1;
+	}
+	*ref = child;
+	mm_free(art->mm, node);
+}
+
+static void
+art_remove_child(struct art *art, void **ref, struct art_node *node, u8 byte,
+                 void **slot)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		unsigned int pos = slot - n->child;
+		memmove(n->key + pos, n->key + pos + 1, node->count - 1 - pos);
+		memmove(n->child + pos, n->child + pos + 1, 
+		        (node->count - 1 - pos) * sizeof(void *));
+		node->count--;
+		art_collapse(art, ref, node);
+		return;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		unsigned int pos = slot - n->child;
+		memmove(n->key + pos, n->key + pos + 1, node->count - 1 - pos);
+		memmove(n->child + pos, n->child + pos + 1, 
+		        (node->count - 1 - pos) * sizeof(void *));
+		if (--node->count > 3)
+			return;
+		struct art_node4 *shrunk = (struct art_node4 *)
+			art_node_move(art, node, ART_NODE4);
+		memcpy(shrunk->key, n->key, 3);
+		memcpy(shrunk->child, n->child, 3 * sizeof(void *));
+		mm_free(art->mm, node);
+		*ref = shrunk;
+		return;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		n->child[n->index[byte] - 1] = NULL;
+		n->index[byte] = 0;
+		if (--node->count > 12)
+			return;
+		struct art_node16 *shrunk = (struct art_node16 *)
+			art_node_move(art, node, ART_NODE16);
+		for (unsigned int b = 0, i = 0; b < 256; b++)
+			if (n->index[b]) {
+				shrunk->key[i] = b;
+				shrunk->child[i++] = n->child[n->index[b] - 1];
+			}
+		mm_free(art->mm, node);
+		*ref = shrunk;
+		return;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		n->child[byte] = NULL;
+		if (--node->count > 37)
+			return;
+		struct art_node48 *shrunk = (struct art_node48 *)
+			art_node_move(art, node, ART_NODE48);
+		for (unsigned int b = 0, i = 0; b < 256; b++)
+			if (n->child[b]) {
+				shrunk->child[i] = n->child[b];
+				shrunk->index[b] = ++i;
+			}
+		mm_free(art->mm, node);
+		*ref = shrunk;
+		return;
+	}
+	}
+}
+
+/* puts a leaf into a fresh node4 whose prefix ends at depth */
+static void
+art_attach(struct art *art, void **ref, struct art_node *node, 
+           struct art_leaf *leaf, size_t depth)
+{
+	if (depth == leaf->len)
+		node->leaf = leaf;
+	else
+		art_add_child(art, ref, node, leaf->key[depth], art_leaf_tag(leaf));
+}
+
+static int
+art_insert_at(struct art *art, void **ref, const u8 *key, size_t len, 
+              size_t depth, void *val)
+{
+	void *ptr = *ref;
+	if (!ptr) {
+		*ref = art_leaf_tag(art_leaf_new(art, key, len, val));
+		return 1;
+	}
+
+	if (art_is_leaf(ptr)) {
+		struct art_leaf *old = art_leaf(ptr);
+		if (art_leaf_eq(old, key, len)) {
+			old->val = val;
+			return 0;
+		}
+		struct art_node *node = art_node_new(art, ART_NODE4);
+		size_t max = __min((size_t)old->len, len), lcp = depth;
+		while (lcp < max && old->key[lcp] == key[lcp])
+			lcp++;
+		node->prefix_len = lcp - depth;
+		memcpy(node->prefix, key + depth, __min(lcp - depth, ART_PREFIX));
+		*ref = node;
+		art_attach(art, ref, node, old, lcp);
+		art_attach(art, ref, node, art_leaf_new(art, key, len, val), lcp);
+		return 1;
+	}
+
+	struct art_node *node = ptr;
+	if (node->prefix_len) {
+		size_t diff = art_prefix_mismatch(node, key, len, depth);
+		if (diff < node->prefix_len) {
+			struct art_node *split = art_node_new(art, ART_NODE4);
+			split->prefix_len = diff;
+			memcpy(split->prefix, node->prefix, __min(diff, ART_PREFIX));
+			if (node->prefix_len <= ART_PREFIX) {
+				art_add_child(art, ref, split, node->prefix[diff], node);
+				node->prefix_len -= diff + 1;
+				memmove(node->prefix, node->prefix + diff + 1, 
+				        node->prefix_len);
+			} else {
+				const struct art_leaf *min = art_minimum(node);
+				art_add_child(art, ref, split, min->key[depth + diff], node);
+				node->prefix_len -= diff + 1;
+				memcpy(node->prefix, min->key + depth + diff + 1, 
+				       __min(node->prefix_len, ART_PREFIX));
+			}
+			*ref = split;
+			art_attach(art, ref, split, art_leaf_new(art, key, len, val), 
+			           depth + diff);
+			return 1;
+		}
+		depth += node->prefix_len;
+	}
+
+	if (depth == len) {
+		if (node->leaf) {
+			node->leaf->val = val;
+			return 0;
+		}
+		node->leaf = art_leaf_new(art, key, len, val);
+		return 1;
+	}
+
+	void **child = art_child(node, key[depth]);
+	if (child)
+		return art_insert_at(art, child, key, len, depth + 1, val);
+	art_add_child(art, ref, node, key[depth], 
+	              art_leaf_tag(art_leaf_new(art, key, len, val)));
+	return 1;
+}
+
+static int
+art_del_at(struct art *art, void **ref, const u8 *key, size_t len, 
+           size_t depth, void **val)
+{
+	void *ptr = *ref;
+	if (!ptr)
+		return 0;
+
+	if (art_is_leaf(ptr)) {
+		if (!art_leaf_eq(art_leaf(ptr), key, len))
+			return 0;
+		*ref = NULL;
+		art_leaf_free(art, art_leaf(ptr), val);
+		return 1;
+	}
+
+	struct art_node *node = ptr;
+	if (node->prefix_len) {
+		if (depth + node->prefix_len > len || 
+		    art_check_prefix(node, key, depth) != __min(node->prefix_len, ART_PREFIX))
+			return 0;
+		depth += node->prefix_len;
+	}
+
+	if (depth == len) {
+		struct art_leaf *leaf = node->leaf;
+		if (!leaf || !art_leaf_eq(leaf, key, len))
+			return 0;
+		node->leaf = NULL;
+		art_leaf_free(art, leaf, val);
+		if (node->type == ART_NODE4)
+			art_collapse(art, ref, node);
+		return 1;
+	}
+
+	void **child = art_child(node, key[depth]);
+	if (!child)
+		return 0;
+	if (!art_is_leaf(*child))
+		return art_del_at(art, child, key, len, depth + 1, val);
+
+	struct art_leaf *leaf = art_leaf(*child);
+	if (!art_leaf_eq(leaf, key, len))
+		return 0;
+	art_remove_child(art, ref, node, key[depth], child);
+	art_leaf_free(art, leaf, val);
+	return 1;
+}
+
+static void
+art_free(struct art *art, void *ptr)
+{
+	if (art_is_leaf(ptr)) {
+		mm_free(art->mm, art_leaf(ptr));
+		return;
+	}
+
+	struct art_node *node = ptr;
+	if (node->leaf)
+		mm_free(art->mm, node->leaf);
+	switch (node->type) {
+	case ART_NODE4:
+		for (unsigned int i = 0; i < node->count; i++)
+			art_free(art, ((struct art_node4 *)node)->child[i]);
+		break;
+	case ART_NODE16:
+		for (unsigned int i = 0; i < node->count; i++)
+			art_free(art, ((struct art_node16 *)node)->child[i]);
+		break;
+	case ART_NODE48:
+		for (unsigned int i = 0; i < 48; i++)
+			if (((struct art_node48 *)node)->child[i])
+				art_free(art, ((struct art_node48 *)node)->child[i]);
+		break;
+	case ART_NODE256:
+		for (unsigned int b = 0; b < 256; b++)
+			if (((struct art_node256 *)node)->child[b])
+				art_free(art, ((struct art_node256 *)node)->child[b]);
+		break;
+	}
+	mm_free(art->mm, node);
+}
+
+static int
+art_walk_at(const void *ptr, 
+            int (*fn)(void *ctx, const u8 *key, size_t len, void *val),
+            void *ctx)
+{
+	int rv;
+	if (art_is_leaf(ptr)) {
+		const struct art_leaf *leaf = art_leaf(ptr);
+		return fn(ctx, leaf->key, leaf->len, leaf->val);
+	}
+
+	const struct art_node *node = ptr;
+	if (node->leaf && 
+	    (rv = fn(ctx, node->leaf->key, node->leaf->len, node->leaf->val)))
+		return rv;
+
+	switch (node->type) {
+	case ART_NODE4:
+		for (unsigned int i = 0; i < node->count; i++)
+			if ((rv = art_walk_at(((struct art_node4 *)node)->child[i], fn, ctx)))
+				return rv;
+		break;
+	case ART_NODE16:
+		for (unsigned int i = 0; i < node->count; i++)
+			if ((rv = art_walk_at(((struct art_node16 *)node)->child[i], fn, ctx)))
+				return rv;
+		break;
+	case ART_NODE48: {
+		const struct art_node48 *n = (const struct art_node48 *)node;
+		for (unsigned int b = 0; b < 256; b++)
+			if (n->index[b] && 
+			    (rv = art_walk_at(n->child[n->index[b] - 1], fn, ctx)))
+				return rv;
+		break;
+	}
+	case ART_NODE256: {
+		const struct art_node256 *n = (const struct art_node256 *)node;
+		for (unsigned int b = 0; b < 256; b++)
+			if (n->child[b] && (rv = art_walk_at(n->child[b], fn, ctx)))
+				return rv;
+		break;
+	}
+	}
+	return 0;
+}
+
+void
+art_init(struct art *art, struct mm *mm)
+{
+	art->mm = mm;
+	art->root = NULL;
+	art->count = 0;
+}
+
+void
+art_fini(struct art *art)
+{
+	if (art->root)
+		art_free(art, art->root);
+	art->root = NULL;
+	art->count = 0;
+}
+
+int
+art_insert(struct art *art, const void *key, size_t len, void *val)
+{
+	int added = art_insert_at(art, &art->root, key, len, 0, val);
+	art->count += added;
+	return added;
+}
+
+int
+art_del(struct art *art, const void *key, size_t len, void **val)
+{
+	int removed = art_del_at(art, &art->root, key, len, 0, val);
+	art->count -= removed;
+	return removed;
+}
+
+int
+art_find(const struct art *art, const void *key, size_t len, void **val)
+{
+	const u8 *k = key;
+	const struct art_leaf *leaf = NULL;
+	void *ptr = art->root;
+	size_t depth = 0;
+
+	while (ptr) {
+		if (art_is_leaf(ptr)) {
+			leaf = art_leaf(ptr);
+			break;
+		}
+		struct art_node *node = ptr;
+		if (node->prefix_len) {
+			if (depth + node->prefix_len > len || 
+			    art_check_prefix(node, k, depth) != __min(node->prefix_len, ART_PREFIX))
+				return 0;
+			depth += node->prefix_len;
+		}
+		if (depth == len) {
+			leaf = node->leaf;
+			break;
+		}
+		void **child = art_child(node, k[depth++]);
+		ptr = child ? *child: NULL;
+	}
+
+	if (!leaf || !art_leaf_eq(leaf, k, len))
+		return 0;
+	if (val)
+		*val = leaf->val;
+	return 1;
+}
+
+int
+art_walk_prefix(const struct art *art, const void *prefix, size_t len,
+                int (*fn)(void *ctx, const u8 *key, size_t len, void *val),
+                void *ctx)
+{
+	const u8 *p = prefix;
+	void *ptr = art->root;
+	size_t depth = 0;
+
+	while (ptr) {
+		if (art_is_leaf(ptr)) {
+			const struct art_leaf *leaf = art_leaf(ptr);
+			if (len && (leaf->len < len || memcmp(leaf->key, p, len)))
+				return 0;
+			return fn(ctx, leaf->key, leaf->len, leaf->val);
+		}
+		struct art_node *node = ptr;
+		if (node->prefix_len && depth < len) {
+			size_t diff = art_prefix_mismatch(node, p, len, depth);
+			if (depth + diff == len)
+				break;
+			if (diff < node->prefix_len)
+				return 0;
+			depth += node->prefix_len;
+		}
+		if (depth == len)
+			break;
+		void **child = art_child(node, p[depth++]);
+		ptr = child ? *child: NULL;
+	}
+	return ptr ? art_walk_at(ptr, fn, ctx): 0;
+}
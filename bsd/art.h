@@ -0,0 +1,191 @@
+/*
+ * Adaptive radix tree
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_ART_H__
+#define __GENERIC_ART_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Adaptive radix tree
+ *
+ * Ordered map of byte string keys to pointers. The tree branches on one key
+ * byte per level, so a lookup reads every key byte once instead of comparing
+ * whole keys on every level like a binary tree, and keys sharing a long 
+ * prefix (URLs, paths) cost no more than others. 
+ *
+ * Inner nodes adapt to the number of children: 
+ *
+ *   node4    up to 4 children, sorted key bytes and pointers
+ *   node16   up to 16, the key bytes are searched with one SSE2 compare
+ *   node48   256 byte index into 48 pointers
+ *   node256  256 pointers
+ *
+ * Path compression: a node stores the bytes all keys below it share, up to
+ * ART_PREFIX of them. Longer prefixes are skipped optimistically and 
+ * checked against the key in the leaf. Lazy expansion: a key is kept as a
+ * leaf with the whole key as soon as it is the only one below a node, 
+ * inner nodes are created only where keys differ.
+ *
+ * Any byte string is a key, a key which is a prefix of other keys is kept 
+ * in the node where it ends. Keys are ordered bytewise, a prefix first.
+ *
+ * Nodes and leaves are taken from @mm and returned with mm_free().
+ *
+ * Time complexity:  O(k) find, insert and delete for a key of k bytes
+ * Space complexity: Θ(n)
+ */
+
+#define ART_PREFIX 8
+
+enum art_type {
+	ART_NODE4   = 1,
+	ART_NODE16  = 2,
+	ART_NODE48  = 3,
+	ART_NODE256 = 4,
+};
+
+struct art_leaf {
+	void *val;
+	u32 len;
+	u8 key[];
+};
+
+struct art_node {
+	u8 type;
+	u8 pad;
+	u16 count;            /* children                                  */
+	u32 prefix_len;       /* bytes skipped, only ART_PREFIX are kept   */
+	u8 prefix[ART_PREFIX];
+	struct art_leaf *leaf;/* key which ends here                       */
+};
+
+struct art_node4 {
+	struct art_node node;
+	u8 key[4];
+	void *child[4];
+};
+
+struct art_node16 {
+	struct art_node node;
+	u8 key[16];
+	void *child[16];
+};
+
+struct art_node48 {
+	struct art_node node;
+	u8 index[256];        /* slot + 1, 0 is no child                   */
+	void *child[48];
+};
+
+struct art_node256 {
+	struct art_node node;
+	void *child[256];
+};
+
+struct art {
+	struct mm *mm;
+	void *root;
+	size_t count;
+};
+
+void
+art_init(struct art *art, struct mm *mm);
+
+void
+art_fini(struct art *art);
+
+/**
+ * art_insert - insert or replace
+ *
+ * @art:        the tree
+ * @key:        the key
+ * @len:        key length in bytes
+ * @val:        the value
+ *
+ * Returns 1 when the key was added, 0 when its value was replaced.
+ */
+
+int
+art_insert(struct art *art, const void *key, size_t len, void *val);
+
+/**
+ * art_del - remove a key
+ *
+ * @art:        the tree
+ * @key:        the key
+ * @len:        key length in bytes
+ * @val:        optional, gets the removed value
+ *
+ * Returns 1 when the key was removed, 0 when it was not there.
+ */
+
+int
+art_del(struct art *art, const void *key, size_t len, void **val);
+
+/**
+ * art_find - value of a key
+ *
+ * @art:        the tree
+ * @key:        the key
+ * @len:        key length in bytes
+ * @val:        gets the value when found
+ *
+ * Returns 1 when the key was found.
+ */
+
+int
+art_find(const struct art *art, const void *key, size_t len, void **val);
+
+/**
+ * art_walk_prefix - visit keys starting with a prefix in order
+ *
+ * @art:        the tree
+ * @prefix:     the prefix, NULL with @len 0 visits every key
+ * @len:        prefix length in bytes
+ * @fn:         called for every key, a non-zero return stops the walk
+ * @ctx:        passed to @fn
+ *
+ * Returns the value which stopped the walk or 0.
+ */
+
+int
+art_walk_prefix(const struct art *art, const void *prefix, size_t len,
+                int (*fn)(void *ctx, const u8 *key, size_t len, void *val),
+                void *ctx);
+
+#define art_walk(art, fn, ctx) art_walk_prefix(art, NULL, 0, fn, ctx)
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,443 @@
+/*
+ * B+tree ordered map
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/btree.h>
+#include <string.h>
+
+struct btree_path {
+	struct btree_inner *node;
+	unsigned int pos;     /* child taken on the way down               */
+};
+
+static struct btree_leaf *
+btree_leaf_new(struct btree *btree)
+{
+	struct btree_leaf *leaf = mm_alloc(btree->mm, sizeof(*leaf));
+	leaf->count = 0;
+	leaf->leaf = 1;
+	leaf->prev = leaf->next = NULL;
+	return leaf;
+}
+
+static struct btree_inner *
+btree_inner_new(struct btree *btree)
+{
+	struct btree_inner *node = mm_alloc(btree->mm, sizeof(*node));
+	node->count = 0;
+	node->leaf = 0;
+	return node;
+}
+
+void
+btree_init(struct btree *btree, struct mm *mm)
+{
+	*btree = (struct btree) { .mm = mm };
+}
+
+static void
+btree_free(struct btree *btree, void *node, unsigned int height)
+{
+	if (height > 1) {
+		struct btree_inner *inner = node;
+		for (unsigned int i = 0; i <= inner->count; i++)
+			btree_free(btree, inner->child[i], height - 1);
+	}
+	mm_free(btree->mm, node);
+}
+
+void
+btree_fini(struct btree *btree)
+{
+	if (btree->root)
+		btree_free(btree, btree->root, btree->height);
+	btree_init(btree, btree->mm);
+}
+
+/* walks down to the leaf which may hold @key and records the path */
+static struct btree_leaf *
+btree_descend(struct btree *btree, u64 key, struct btree_path *path)
+{
+	void *node = btree->root;
+	for (unsigned int h = 0; h + 1 < btree->height; h++) {
+		struct btree_inner *inner = node;
+		path[h].node = inner;
+		path[h].pos = btree_child(inner, key);
+		node = inner->child[path[h].pos];
+	}
+	return node;
+}
+
+static void
+btree_leaf_insert(struct btree_leaf *leaf, unsigned int pos, u64 key, void *val)
+{
+	unsigned int n = leaf->count - pos;
+	memmove(leaf->key + pos + 1, leaf->key + pos, n * sizeof(u64));
+	memmove(leaf->val + pos + 1, leaf->val + pos, n * sizeof(void *));
+	leaf->key[pos] = key;
+	leaf->val[pos] = val;
+	leaf->count++;
+}
+
+static void
+btree_leaf_unlink(struct btree *btree, struct btree_leaf *leaf)
+{
+	if (leaf->prev)
+		leaf->prev->next = leaf->next;
+	else
+		btree->first = leaf->next;
+	if (leaf->next)
+		leaf->next->prev = leaf->prev;
+	else
+		btree->last = leaf->prev;
+	mm_free(btree->mm, leaf);
+}
+
+/* inserts separator @key at @pos with its right child */
+static void
+btree_inner_insert(struct btree_inner *node, unsigned int pos, u64 key, 
+                   void *child)
+{
+	unsigned int n = node->count - pos;
+	memmove(node->key + pos + 1, node->key + pos, n * sizeof(u64));
+	memmove(node->child + pos + 2, node->child + pos + 1, n * sizeof(void *));
+	node->key[pos] = key;
+	node->child[pos + 1] = child;
+	node->count++;
+}
+
+/* removes separator @pos with its right child */
+static void
+btree_inner_remove(struct btree_inner *node, unsigned int pos)
+{
+	unsigned int n = node->count - pos - 1;
+	memmove(node->key + pos, node->key + pos + 1, n * sizeof(u64));
+	memmove(node->child + pos + 1, node->child + pos + 2, n * sizeof(void *));
+	node->count--;
+}
+
+/* appends separator @key and all of @src to @dst */
+static void
+btree_inner_merge(struct btree_inner *dst, u64 key, struct btree_inner *src)
+{
+	dst->key[dst->count] = key;
+	memcpy(dst->key + dst->count + 1, src->key, src->count * sizeof(u64));
+	memcpy(dst->child + dst->count + 1, src->child, 
+	       (src->count + 1) * sizeof(void *));
+	dst->count += src->count + 1;
+}
+
+/* 
+ * Adds separator @key and node @right next to the child taken at level @h,
+ * full nodes are split on the way up.
+ */
+
+static void
+btree_grow(struct btree *btree, struct btree_path *path, int h, u64 key,
+           void *right)
+{
+	for (; h >= 0; h--) {
+		struct btree_inner *node = path[h].node, *split;
+		unsigned int pos = path[h].pos;
+		if (node->count < BTREE_KEYS) {
+			btree_inner_insert(node, pos, key, right);
+			return;
+		}
+
+		u64 k[BTREE_KEYS + 1];
+		void *c[BTREE_KEYS + 2];
+		memcpy(k, node->key, pos * sizeof(u64));
+		memcpy(k + pos + 1, node->key + pos, (BTREE_KEYS - pos) * sizeof(u64));
+		memcpy(c, node->child, (pos + 1) * sizeof(void *));
+		memcpy(c + pos + 2, node->child + pos + 1, 
+		       (BTREE_KEYS - pos) * sizeof(void *));
+		k[pos] = key;
+		c[pos + 1] = right;
+
+		split = btree_inner_new(btree);
+		node->count = BTREE_MIN;
+		memcpy(node->key, k, BTREE_MIN * sizeof(u64));
+		memcpy(node->child, c, (BTREE_MIN + 1) * sizeof(void *));
+		split->count = BTREE_KEYS - BTREE_MIN;
+		memcpy(split->key, k + BTREE_MIN + 1, split->count * sizeof(u64));
+		memcpy(split->child, c + BTREE_MIN + 1, 
+		       (split->count + 1) * sizeof(void *));
+		key = k[BTREE_MIN];
+		right = split;
+	}
+
+	struct btree_inner *root = btree_inner_new(btree);
+	root->count = 1;
+	root->key[0] = key;
+	root->child[0] = btree->root;
+	root->child[1] = right;
+	btree->root = root;
+	btree->height++;
+}
+
+int
+btree_insert(struct btree *btree, u64 key, void *val)
+{
+	struct btree_path path[BTREE_MAX_HEIGHT];
+	if (!btree->root) {
+		btree->root = btree->first = btree->last = btree_leaf_new(btree);
+		btree->height = 1;
+	}
+
+	struct btree_leaf *leaf = btree_descend(btree, key, path);
+	unsigned int pos = btree_rank(leaf->key, leaf->count, key);
+	if (pos < leaf->count && leaf->key[pos] == key) {
+		leaf->val[pos] = val;
+		return 0;
+	}
+
+	btree->count++;
+	if (leaf->count < BTREE_KEYS) {
+		btree_leaf_insert(leaf, pos, key, val);
+		return 1;
+	}
+
+	/* split the full leaf, the upper half moves to a new right sibling */
+	struct btree_leaf *right = btree_leaf_new(btree);
+	right->count = BTREE_KEYS - BTREE_MIN;
+	memcpy(right->key, leaf->key + BTREE_MIN, right->count * sizeof(u64));
+	memcpy(right->val, leaf->val + BTREE_MIN, right->count * sizeof(void *));
+	leaf->count = BTREE_MIN;
+
+	right->prev = leaf;
+	right->next = leaf->next;
+	if (leaf->next)
+		leaf->next->prev = right;
+	else
+		btree->last = right;
+	leaf->next = right;
+
+	if (pos <= BTREE_MIN)
+		btree_leaf_insert(leaf, pos, key, val);
+	else
+		btree_leaf_insert(right, pos - BTREE_MIN, key, val);
+
+	btree_grow(btree, path, (int)btree->height - 2, right->key[0], right);
+	return 1;
+}
+
+/* refills or merges inner nodes on the path which fell below half */
+static void
+btree_inner_fix(struct btree *btree, struct btree_path *path, int h)
+{
+	for (; h > 0; h--) {
+		struct btree_inner *node = path[h].node;
+		if (node->count >= BTREE_MIN)
+			return;
+
+		struct btree_inner *parent = path[h - 1].node;
+		unsigned int ci = path[h - 1].pos;
+		struct btree_inner *left = ci ? parent->child[ci - 1]: NULL;
+		struct btree_inner *right = ci < parent->count ? 
+		                            parent->child[ci + 1]: NULL;
+
+		if (left && left->count > BTREE_MIN) {
+			memmove(node->key + 1, node->key, node->count * sizeof(u64));
+			memmove(node->child + 1, node->child, 
+			        (node->count + 1) * sizeof(void *));
+			node->key[0] = parent->key[ci - 1];
+			node->child[0] = left->child[left->count];
+			parent->key[ci - 1] = left->key[left->count - 1];
+			left->count--;
+			node->count++;
+			return;
+		}
+		if (right && right->count > BTREE_MIN) {
+			node->key[node->count] = parent->key[ci];
+			node->child[node->count + 1] = right->child[0];
+			node->count++;
+			parent->key[ci] = right->key[0];
+			memmove(right->key, right->key + 1, 
+			        (right->count - 1) * sizeof(u64));
+			memmove(right->child, right->child + 1, 
+			        right->count * sizeof(void *));
+			right->count--;
+			return;
+		}
+
+		if (left) {
+			btree_inner_merge(left, parent->key[ci - 1], node);
+			mm_free(btree->mm, node);
+			btree_inner_remove(parent, ci - 1);
+		} else {
+			btree_inner_merge(node, parent->key[ci], right);
+			mm_free(btree->mm, right);
+			btree_inner_remove(parent, ci);
+		}
+	}
+
+	struct btree_inner *root = btree->root;
+	if (!root->count) {
+		btree->root = root->child[0];
+		btree->height--;
+		mm_free(btree->mm, root);
+	}
+}
+
+/* refills a leaf from a sibling or merges it into one */
+static void
+btree_leaf_fix(struct btree *btree, struct btree_path *path,
+               struct btree_leaf *leaf)
+{
+	int h = (int)btree->height - 2;
+	struct btree_inner *parent = path[h].node;
+	unsigned int ci = path[h].pos;
+	struct btree_leaf *left = ci ? parent->child[ci - 1]: NULL;
+	struct btree_leaf *right = ci < parent->count ? parent->child[ci + 1]: NULL;
+
+	if (left && left->count > BTREE_MIN) {
+		memmove(leaf->key + 1, leaf->key, leaf->count * sizeof(u64));
+		memmove(leaf->val + 1, leaf->val, leaf->count * sizeof(void *));
+		leaf->key[0] = left->key[left->count - 1];
+		leaf->val[0] = left->val[left->count - 1];
+		left->count--;
+		leaf->count++;
+		parent->key[ci - 1] = leaf->key[0];
+		return;
+	}
+	if (right && right->count > BTREE_MIN) {
+		leaf->key[leaf->count] = right->key[0];
+		leaf->val[leaf->count] = right->val[0];
+		leaf->count++;
+		right->count--;
+		memmove(right->key, right->key + 1, right->count * sizeof(u64));
+		memmove(right->val, right->val + 1, right->count * sizeof(void *));
+		parent->key[ci] = right->key[0];
+		return;
+	}
+
+	if (left) {
+		memcpy(left->key + left->count, leaf->key, leaf->count * sizeof(u64));
+		memcpy(left->val + left->count, leaf->val, leaf->count * sizeof(void *));
+		left->count += leaf->count;
+		btree_leaf_unlink(btree, leaf);
+		btree_inner_remove(parent, ci - 1);
+	} else {
+		memcpy(leaf->key + leaf->count, right->key, right->count * sizeof(u64));
+		memcpy(leaf->val + leaf->count, right->val, right->count * sizeof(void *));
+		leaf->count += right->count;
+		btree_leaf_unlink(btree, right);
+		btree_inner_remove(parent, ci);
+	}
+
+	btree_inner_fix(btree, path, h);
+}
+
+int
+btree_del(struct btree *btree, u64 key, void **val)
+{
+	struct btree_path path[BTREE_MAX_HEIGHT];
+	if (!btree->root)
+		return 0;
+
+	struct btree_leaf *leaf = btree_descend(btree, key, path);
+	unsigned int pos = btree_rank(leaf->key, leaf->count, key);
+	if (pos == leaf->count || leaf->key[pos] != key)
+		return 0;
+	if (val)
+		*val = leaf->val[pos];
+
+	unsigned int n = leaf->count - pos - 1;
+	memmove(leaf->key + pos, leaf->key + pos + 1, n * sizeof(u64));
+	memmove(leaf->val + pos, leaf->val + pos + 1, n * sizeof(void *));
+	leaf->count--;
+	btree->count--;
+
+	if (btree->height == 1) {
+		if (!leaf->count) {
+			mm_free(btree->mm, leaf);
+			btree_init(btree, btree->mm);
+		}
+		return 1;
+	}
+
+	if (leaf->count < BTREE_MIN)
+		btree_leaf_fix(btree, path, leaf);
+	return 1;
+}
+
+void
+btree_load(struct btree *btree, const u64 *key, void *const *val, size_t count)
+{
+	if (!count)
+		return;
+
+	/* leaves and nodes get an even share, which keeps them half full */
+	size_t n = (count + BTREE_KEYS - 1) / BTREE_KEYS;
+	void **level = mm_alloc(btree->mm, n * sizeof(void *));
+	u64 *low = mm_alloc(btree->mm, n * sizeof(u64));
+	struct btree_leaf *prev = NULL;
+
+	for (size_t i = 0, at = 0; i < n; i++) {
+		struct btree_leaf *leaf = btree_leaf_new(btree);
+		leaf->count = count / n + (i < count % n);
+		memcpy(leaf->key, key + at, leaf->count * sizeof(u64));
+		if (val)
+			memcpy(leaf->val, val + at, leaf->count * sizeof(void *));
+		else
+			memset(leaf->val, 0, leaf->count * sizeof(void *));
+		leaf->prev = prev;
+		if (prev)
+			prev->next = leaf;
+		level[i] = prev = leaf;
+		low[i] = key[at];
+		at += leaf->count;
+	}
+
+	btree->first = level[0];
+	btree->last = prev;
+	btree->height = 1;
+
+	while (n > 1) {
+		size_t m = (n + BTREE_KEYS) / (BTREE_KEYS + 1);
+		for (size_t i = 0, at = 0; i < m; i++) {
+			struct btree_inner *node = btree_inner_new(btree);
+			size_t c = n / m + (i < n % m);
+			node->count = c - 1;
+			memcpy(node->child, level + at, c * sizeof(void *));
+			memcpy(node->key, low + at + 1, (c - 1) * sizeof(u64));
+			level[i] = node;
+			low[i] = low[at];
+			at += c;
+		}
+		n = m;
+		btree->height++;
+	}
+
+	btree->root = level[0];
+	btree->count = count;
+	mm_free(btree->mm, level);
+	mm_free(btree->mm, low);
+}
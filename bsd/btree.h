@@ -0,0 +1,285 @@
+/*
+ * B+tree ordered map
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_BTREE_H__
+#define __GENERIC_BTREE_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * B+tree
+ *
+ * Ordered map of u64 keys to pointers. A red-black tree pays a cache miss 
+ * on every level, about 2 log2(n) levels deep. Here a node holds up to 
+ * BTREE_KEYS keys in one array, about 1 KiB per node, so a lookup visits
+ * log_64(n) nodes: 4 for 10M keys. Inside a node the keys are compared 4 
+ * at a time with AVX2 (scalar branchless binary search otherwise), every 
+ * compare is counted and none is branched on.
+ *
+ * Values live in the leaves only and the leaves are linked in both 
+ * directions, so a range scan walks arrays instead of chasing parent 
+ * pointers. Nodes are at least half full, except the root. Separators in 
+ * inner nodes may be stale after a delete, they only need to split the key
+ * space correctly.
+ *
+ * btree_load() builds the tree from sorted keys bottom up with nodes packed
+ * evenly, which is much faster than inserting one key at a time.
+ *
+ * Nodes are taken from @mm and returned with mm_free().
+ *
+ * Time complexity:  O(log n) find, insert and delete, O(1) iterator step
+ * Space complexity: Θ(n)
+ */
+
+#define BTREE_KEYS       64
+#define BTREE_MIN        (BTREE_KEYS / 2)
+#define BTREE_MAX_HEIGHT 16
+
+struct btree_inner {
+	u32 count;            /* keys, children are count + 1              */
+	u32 leaf;
+	u64 key[BTREE_KEYS];
+	void *child[BTREE_KEYS + 1];
+};
+
+struct btree_leaf {
+	u32 count;
+	u32 leaf;
+	struct btree_leaf *prev, *next;
+	u64 key[BTREE_KEYS];
+	void *val[BTREE_KEYS];
+};
+
+struct btree {
+	struct mm *mm;
+	void *root;
+	struct btree_leaf *first, *last;
+	unsigned int height;  /* 0 empty, 1 root is a leaf                 */
+	size_t count;
+};
+
+struct btree_iter {
+	struct btree_leaf *leaf;
+	unsigned int pos;
+};
+
+void
+btree_init(struct btree *btree, struct mm *mm);
+
+void
+btree_fini(struct btree *btree);
+
+/**
+ * btree_insert - insert or replace
+ *
+ * @btree:      the tree
+ * @key:        the key
+ * @val:        the value
+ *
+ * Returns 1 when the key was added, 0 when its value was replaced.
+ */
+
+int
+btree_insert(struct btree *btree, u64 key, void *val);
+
+/**
+ * btree_del - remove a key
+ *
+ * @btree:      the tree
+ * @key:        the key
+ * @val:        optional, gets the removed value
+ *
+ * Returns 1 when the key was removed, 0 when it was not there.
+ */
+
+int
+btree_del(struct btree *btree, u64 key, void **val);
+
+/**
+ * btree_load - build a tree from sorted keys
+ *
+ * @btree:      empty tree
+ * @key:        strictly ascending keys
+ * @val:        values, NULL stores NULL values
+ * @count:      number of keys
+ */
+
+void
+btree_load(struct btree *btree, const u64 *key, void *const *val, size_t count);
+
+/* number of keys in node less than x */
+static inline unsigned int
+btree_rank(const u64 *key, unsigned int count, u64 x)
+{
+#ifdef __AVX2__
+	const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+	const __m256i v = _mm256_xor_si256(_mm256_set1_epi64x((long long)x), bias);
+	u64 mask = 0;
+	for (unsigned int i = 0; i < count; i += 4) {
+		__m256i k = _mm256_loadu_si256((const __m256i *)(key + i));
+		__m256i lt = _mm256_cmpgt_epi64(v, _mm256_xor_si256(k, bias));
+		mask |= (u64)_mm256_movemask_pd(_mm256_castsi256_pd(lt)) << i;
+	}
+	if (count < 64)
+		mask &= (1ULL << count) - 1;
+	return __builtin_popcountll(mask);
+#else
+	const u64 *base = key;
+	unsigned int n = count;
+	if (!n)
+		return 0;
+	while (n > 1) {
+		unsigned int half = n / 2;
+		base = base[half - 1] < x ? base + half: base;
+		n -= half;
+	}
+	return (unsigned int)(base - key) + (*base < x);
+#endif
+}
+
+/* child of an inner node which may hold x */
+static inline unsigned int
+btree_child(const struct btree_inner *node, u64 x)
+{
+	if (x == ~0ULL)
+		return node->count;
+	return btree_rank(node->key, node->count, x + 1);
+}
+
+static inline struct btree_leaf *
+btree_leaf(const struct btree *btree, u64 key)
+{
+	void *node = btree->root;
+	for (unsigned int h = btree->height; h > 1; h--) {
+		const struct btree_inner *inner = node;
+		node = inner->child[btree_child(inner, key)];
+	}
+	return node;
+}
+
+/**
+ * btree_find - value of a key
+ *
+ * @btree:      the tree
+ * @key:        the key
+ * @val:        gets the value when found
+ *
+ * Returns 1 when the key was found.
+ */
+
+static inline int
+btree_find(const struct btree *btree, u64 key, void **val)
+{
+	if (!btree->root)
+		return 0;
+	struct btree_leaf *leaf = btree_leaf(btree, key);
+	unsigned int pos = btree_rank(leaf->key, leaf->count, key);
+	if (pos == leaf->count || leaf->key[pos] != key)
+		return 0;
+	if (val)
+		*val = leaf->val[pos];
+	return 1;
+}
+
+/**
+ * btree_seek - iterator at the first key not less than @key
+ *
+ * @btree:      the tree
+ * @key:        the key
+ * @it:         the iterator
+ *
+ * Returns 0 when every key is less than @key.
+ */
+
+static inline int
+btree_seek(const struct btree *btree, u64 key, struct btree_iter *it)
+{
+	it->leaf = btree->root ? btree_leaf(btree, key): NULL;
+	it->pos = it->leaf ? btree_rank(it->leaf->key, it->leaf->count, key): 0;
+	if (it->leaf && it->pos == it->leaf->count)
+		it->leaf = it->leaf->next, it->pos = 0;
+	return it->leaf != NULL;
+}
+
+static inline int
+btree_first(const struct btree *btree, struct btree_iter *it)
+{
+	it->leaf = btree->first;
+	it->pos = 0;
+	return it->leaf != NULL;
+}
+
+static inline int
+btree_last(const struct btree *btree, struct btree_iter *it)
+{
+	it->leaf = btree->last;
+	it->pos = it->leaf ? it->leaf->count - 1: 0;
+	return it->leaf != NULL;
+}
+
+static inline int
+btree_next(struct btree_iter *it)
+{
+	if (++it->pos == it->leaf->count)
+		it->leaf = it->leaf->next, it->pos = 0;
+	return it->leaf != NULL;
+}
+
+static inline int
+btree_prev(struct btree_iter *it)
+{
+	if (it->pos-- == 0 && (it->leaf = it->leaf->prev))
+		it->pos = it->leaf->count - 1;
+	return it->leaf != NULL;
+}
+
+#define btree_key(it) ((it)->leaf->key[(it)->pos])
+#define btree_val(it) ((it)->leaf->val[(it)->pos])
+
+/**
+ * btree_walk - iterate over keys from the first not less than @from
+ *
+ * @btree:      the tree
+ * @it:         struct btree_iter
+ * @from:       the first key
+ */
+
+#define btree_walk(btree, it, from) \
+	for (int __ok = btree_seek(btree, from, it); __ok; __ok = btree_next(it))
+
+__END_DECLS
+
+#endif
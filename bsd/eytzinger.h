@@ -0,0 +1,158 @@
+/*
+ * Eytzinger layout for static sorted sets
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_EYTZINGER_H__
+#define __GENERIC_EYTZINGER_H__
+
+#include <stddef.h>
+
+/*
+ * Eytzinger layout
+ *
+ * A static sorted set stored as an implicit binary search tree in breadth 
+ * first order: the root at index 1, the children of k at 2k and 2k + 1, 
+ * index 0 is unused. A binary search over a sorted array touches a new 
+ * cache line on nearly every step and its first steps are spread over the 
+ * whole array. Here the top levels share a few hot cache lines, and the 
+ * descendants of k four levels down (for 4 byte keys) are one contiguous 
+ * cache line at 16k, so it is prefetched while the four compares above it
+ * run. The step k = 2k + less(node, key) has no branch to mispredict.
+ *
+ * name_build(eyt, sorted, count) fills eyt[1..count] from a sorted array,
+ * eytzinger_from_rb() from an in-order walk of a red-black tree. Keep the 
+ * array 64 byte aligned so the prefetched blocks are whole cache lines.
+ *
+ * name_lower_bound(eyt, count, key) is the index of the first element not 
+ * less than key, 0 when every element is less. name_find() is the index of 
+ * an equal element or 0. eytzinger_next() and eytzinger_prev() step to the
+ * neighbour in sorted order, 0 past the ends.
+ *
+ *   DEFINE_EYTZINGER(u64_eyt, u64, eytzinger_less)
+ *   u64 *eyt = aligned_alloc(64, ((count + 1) * 8 + 63) & ~63);
+ *   u64_eyt_build(eyt, sorted, count);
+ *   size_t k = u64_eyt_lower_bound(eyt, count, key);
+ *
+ * Time complexity:  O(log n) search, O(n) build, O(1) amortized step
+ * Space complexity: Θ(n)
+ */
+
+#define eytzinger_less(a, b) ((a) < (b))
+
+/* elements of one cache line, at least the two children */
+#define EYTZINGER_AHEAD(type) \
+	(64 / sizeof(type) > 2 ? 64 / sizeof(type): 2)
+
+/* index of the least element */
+static inline size_t
+eytzinger_first(size_t count)
+{
+	size_t k = 1;
+	while (2 * k <= count)
+		k = 2 * k;
+	return count ? k: 0;
+}
+
+/* index of the greatest element */
+static inline size_t
+eytzinger_last(size_t count)
+{
+	size_t k = 1;
+	while (2 * k + 1 <= count)
+		k = 2 * k + 1;
+	return count ? k: 0;
+}
+
+/* in-order successor of k, 0 after the last one */
+static inline size_t
+eytzinger_next(size_t k, size_t count)
+{
+	if (2 * k + 1 <= count) {
+		k = 2 * k + 1;
+		while (2 * k <= count)
+			k = 2 * k;
+		return k;
+	}
+	return k >> __builtin_ffsll(~(unsigned long long)k);
+}
+
+/* in-order predecessor of k, 0 before the first one */
+static inline size_t
+eytzinger_prev(size_t k, size_t count)
+{
+	if (2 * k <= count) {
+		k = 2 * k;
+		while (2 * k + 1 <= count)
+			k = 2 * k + 1;
+		return k;
+	}
+	return k >> __builtin_ffsll((unsigned long long)k);
+}
+
+/*
+ * Fills eyt[1..count] from a red-black tree of count elements, expr is the
+ * value stored for element x.
+ */
+#define eytzinger_from_rb(eyt, count, name, head, x, expr) \
+do { \
+	size_t __k = eytzinger_first(count); \
+	RB_FOREACH(x, name, head) { \
+		(eyt)[__k] = (expr); \
+		__k = eytzinger_next(__k, count); \
+	} \
+} while (0)
+
+#define __DEFINE_EYTZINGER(storage, name, type, less) \
+storage void \
+name##_build(type *eyt, const type *sorted, size_t count) \
+{ \
+	size_t k = eytzinger_first(count); \
+	for (size_t i = 0; i < count; i++) { \
+		eyt[k] = sorted[i]; \
+		k = eytzinger_next(k, count); \
+	} \
+} \
+storage size_t \
+name##_lower_bound(const type *eyt, size_t count, type key) \
+{ \
+	size_t k = 1; \
+	while (k <= count) { \
+		__builtin_prefetch(eyt + k * EYTZINGER_AHEAD(type)); \
+		k = 2 * k + !!less(eyt[k], key); \
+	} \
+	return k >> __builtin_ffsll(~(unsigned long long)k); \
+} \
+storage size_t \
+name##_find(const type *eyt, size_t count, type key) \
+{ \
+	size_t k = name##_lower_bound(eyt, count, key); \
+	return k && !less(key, eyt[k]) ? k: 0; \
+}
+
+#define DEFINE_EYTZINGER(name, type, less) \
+	__DEFINE_EYTZINGER(static inline __attribute__((unused)), name, type, less)
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Blocked Bloom filter
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/bloom.h>
+#include <string.h>
+#include <math.h>
+
+/* 
+ * Expected false positive rate of the blocked filter, the number of keys per
+ * block follows Poisson distribution and every block is a classic filter.
+ */
+
+static double
+bloom_blocked_fpp(double keys_per_block, unsigned int k)
+{
+	double fpp = 0, p = exp(-keys_per_block);
+	unsigned int max = (unsigned int)(keys_per_block + 10 * sqrt(keys_per_block) + 10);
+	for (unsigned int i = 0; i <= max; i++) {
+		if (i)
+			p *= keys_per_block / i;
+		double zero = pow(1.0 - 1.0 / BLOOM_BLOCK_BITS, (double)k * i);
+		fpp += p * pow(1.0 - zero, k);
+	}
+	return fpp;
+}
+
+#define BLOOM_LN2 0.6931471805599453
+
+int
+bloom_init(struct bloom *bloom, struct mm *mm, u64 keys, double fpp)
+{
+	if (!(fpp > 0 && fpp < 1))
+		return -1;
+
+	/* start with the optimal size of the classic filter: -ln(p)/ln(2)^2 */
+	double bits = keys ? -log(fpp) / (BLOOM_LN2 * BLOOM_LN2) : 1;
+	u64 blocks = (u64)ceil(bits * keys / BLOOM_BLOCK_BITS), n = 1;
+	unsigned int k = 1;
+	while (n < blocks)
+		n <<= 1;
+
+	/* blocking costs some accuracy, grow until the target is met */
+	for (;; n <<= 1) {
+		double best = 1, rate;
+		double load = (double)keys / n;
+		for (unsigned int i = 1; i <= BLOOM_MAX_K; i++)
+			if ((rate = bloom_blocked_fpp(load, i)) < best) {
+				best = rate;
+				k = i;
+			}
+		if (best <= fpp || !keys)
+			break;
+	}
+
+	bloom->k = k;
+	bloom->mm = mm;
+	bloom->mask = n - 1;
+	bloom->addr = mm_alloc(mm, bloom_size(bloom) + CPU_CACHE_LINE);
+	bloom->blocks = (u64 *)(((uintptr_t)bloom->addr + CPU_CACHE_LINE - 1) &
+	                        ~(uintptr_t)(CPU_CACHE_LINE - 1));
+	bloom_reset(bloom);
+	return 0;
+}
+
+void
+bloom_fini(struct bloom *bloom)
+{
+	mm_free(bloom->mm, bloom->addr);
+	bloom->addr = bloom->blocks = NULL;
+}
+
+void
+bloom_reset(struct bloom *bloom)
+{
+	memset(bloom->blocks, 0, bloom_size(bloom));
+}
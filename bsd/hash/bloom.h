@@ -0,0 +1,130 @@
+/*
+ * Blocked Bloom filter
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_BLOOM_H__
+#define __GENERIC_HASH_BLOOM_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Blocked Bloom filter
+ *
+ * Putze, Sanders, Singler: Cache-, Hash- and Space-Efficient Bloom Filters
+ *
+ * Every key sets all of its k bits inside a single 512-bit block, so an add 
+ * or a test touches exactly one cache line. The block and the k bit positions
+ * are all derived from one 64-bit hash (hash_u64(x, 64), hash_buffer(), ...),
+ * the upper half selects the block and the lower half seeds a multiplicative
+ * sequence whose top 9 bits give the probes.
+ *
+ * Keys can not be removed, see cuckoo.h for a filter with deletion.
+ */
+
+#define BLOOM_BLOCK_BITS  512
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BITS / 64)
+#define BLOOM_MAX_K       16
+
+struct bloom {
+	struct mm *mm;
+	void *addr;           /* allocated memory                          */
+	u64 *blocks;          /* cache line aligned blocks                 */
+	u64 mask;             /* number of blocks - 1                      */
+	unsigned int k;       /* bits set per key                          */
+};
+
+/*
+ * bloom_init - create filter for expected number of keys
+ *
+ * @bloom:      the filter
+ * @mm:         memory context
+ * @keys:       expected number of keys
+ * @fpp:        target false positive probability
+ *
+ * Returns 0 on success or -1 when @fpp is not between 0 and 1.
+ */
+
+int
+bloom_init(struct bloom *bloom, struct mm *mm, u64 keys, double fpp);
+
+void
+bloom_fini(struct bloom *bloom);
+
+void
+bloom_reset(struct bloom *bloom);
+
+/* size of the filter in bytes */
+static inline size_t
+bloom_size(const struct bloom *bloom)
+{
+	return (size_t)(bloom->mask + 1) * (BLOOM_BLOCK_BITS / 8);
+}
+
+static inline u64 *
+bloom_block(const struct bloom *bloom, u64 hash)
+{
+	return bloom->blocks + ((hash >> 32) & bloom->mask) * BLOOM_BLOCK_WORDS;
+}
+
+static inline void
+bloom_add(struct bloom *bloom, u64 hash)
+{
+	u64 *block = bloom_block(bloom, hash);
+	u32 x = (u32)hash;
+	for (unsigned int i = 0; i < bloom->k; i++) {
+		x *= 0x9e3779b1;
+		block[x >> 29] |= 1ULL << ((x >> 23) & 63);
+	}
+}
+
+static inline int
+bloom_test(const struct bloom *bloom, u64 hash)
+{
+	const u64 *block = bloom_block(bloom, hash);
+	u32 x = (u32)hash;
+	u64 miss = 0;
+	for (unsigned int i = 0; i < bloom->k; i++) {
+		x *= 0x9e3779b1;
+		miss |= ~block[x >> 29] & (1ULL << ((x >> 23) & 63));
+	}
+	return !miss;
+}
+
+static inline void
+bloom_prefetch(const struct bloom *bloom, u64 hash)
+{
+	__builtin_prefetch(bloom_block(bloom, hash));
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * Bounded key/value cache with LRU and S3-FIFO eviction
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/cache.h>
+#include <string.h>
+
+#define CACHE_FREQ_MAX 3
+
+static inline unsigned int
+cache_bucket(struct cache *cache, u64 hash)
+{
+	return (unsigned int)(hash >> (64 - cache->bits));
+}
+
+void
+cache_init(struct cache *cache, struct mm *mm, u64 capacity, 
+           enum cache_policy policy,
+           int (*eq)(struct cache_node *node, const void *key),
+           void (*evict)(struct cache *cache, struct cache_node *node))
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->mm = mm;
+	cache->policy = policy;
+	cache->capacity = __max(capacity, 1);
+	cache->eq = eq;
+	cache->evict = evict;
+
+	/* one bucket per item keeps chains short */
+	cache->bits = 1;
+	while (((u64)1 << cache->bits) < cache->capacity)
+		cache->bits++;
+
+	size_t buckets = (size_t)1 << cache->bits;
+	cache->table = mm_alloc(mm, buckets * sizeof(*cache->table));
+	for (size_t i = 0; i < buckets; i++)
+		cache->table[i] = init_tailq;
+
+	list_init(&cache->main);
+	list_init(&cache->small);
+
+	if (policy != CACHE_S3FIFO)
+		return;
+
+	cache->small_capacity = __max(cache->capacity / 10, 1);
+	cache->ghost_mask = buckets - 1;
+	cache->ghost = mm_alloc(mm, buckets * sizeof(u64));
+	cache->ghost_time = mm_alloc(mm, buckets * sizeof(u64));
+	memset(cache->ghost, 0, buckets * sizeof(u64));
+	memset(cache->ghost_time, 0, buckets * sizeof(u64));
+}
+
+void
+cache_del(struct cache *cache, struct cache_node *node)
+{
+	hash_del(&node->hnode);
+	list_del(&node->qnode);
+	if (cache->policy == CACHE_S3FIFO && !node->main)
+		cache->small_size--;
+	cache->size--;
+}
+
+static void
+cache_drop(struct cache *cache, struct cache_node *node)
+{
+	cache_del(cache, node);
+	cache->stat.evictions++;
+	if (cache->evict)
+		cache->evict(cache, node);
+}
+
+void
+cache_fini(struct cache *cache)
+{
+	struct node *n;
+	while ((n = list_first(&cache->small)))
+		cache_drop(cache, __container_of(n, struct cache_node, qnode));
+	while ((n = list_first(&cache->main)))
+		cache_drop(cache, __container_of(n, struct cache_node, qnode));
+
+	mm_free(cache->mm, cache->table);
+	if (cache->ghost) {
+		mm_free(cache->mm, cache->ghost);
+		mm_free(cache->mm, cache->ghost_time);
+	}
+	cache->table = NULL;
+	cache->ghost = cache->ghost_time = NULL;
+}
+
+/*
+ * The ghost is a direct mapped table of hashes, an entry is valid while no 
+ * more than capacity other hashes were added after it. Collisions just 
+ * forget the older hash.
+ */
+
+static inline void
+cache_ghost_add(struct cache *cache, u64 hash)
+{
+	u64 i = hash & cache->ghost_mask;
+	cache->ghost[i] = hash;
+	cache->ghost_time[i] = ++cache->ghost_clock;
+}
+
+static inline int
+cache_ghost_has(struct cache *cache, u64 hash)
+{
+	u64 i = hash & cache->ghost_mask;
+	return cache->ghost[i] == hash && cache->ghost_time[i] &&
+	       cache->ghost_clock - cache->ghost_time[i] < cache->capacity;
+}
+
+static void
+cache_evict_s3fifo(struct cache *cache)
+{
+	struct node *n;
+	struct cache_node *node;
+
+	/* small FIFO: promote items hit while in it, others become ghosts */
+	while (cache->small_size >= cache->small_capacity || 
+	       list_empty(&cache->main)) {
+		if (!(n = list_last(&cache->small)))
+			break;
+		node = __container_of(n, struct cache_node, qnode);
+		if (node->freq) {
+			list_del(n);
+			list_add(&cache->main, n);
+			cache->small_size--;
+			node->main = 1;
+			node->freq = 0;
+			continue;
+		}
+		cache_ghost_add(cache, node->hash);
+		cache_drop(cache, node);
+		return;
+	}
+
+	/* main FIFO: reinsert items with remaining frequency */
+	while ((n = list_last(&cache->main))) {
+		node = __container_of(n, struct cache_node, qnode);
+		if (node->freq) {
+			node->freq--;
+			list_mov_head(&cache->main, n);
+			continue;
+		}
+		cache_drop(cache, node);
+		return;
+	}
+}
+
+static void
+cache_evict(struct cache *cache)
+{
+	struct node *n;
+	if (cache->policy == CACHE_S3FIFO) {
+		cache_evict_s3fifo(cache);
+	} else if ((n = list_last(&cache->main))) {
+		cache_drop(cache, __container_of(n, struct cache_node, qnode));
+	}
+}
+
+struct cache_node *
+cache_get(struct cache *cache, u64 hash, const void *key)
+{
+	unsigned int bucket = cache_bucket(cache, hash);
+	struct qnode *it;
+
+	tailq_walk(&cache->table[bucket], it) {
+		struct cache_node *node = 
+			__container_of(it, struct cache_node, hnode);
+		if (node->hash != hash || !cache->eq(node, key))
+			continue;
+
+		cache->stat.hits++;
+		if (cache->policy == CACHE_S3FIFO) {
+			if (node->freq < CACHE_FREQ_MAX)
+				node->freq++;
+		} else {
+			list_mov_head(&cache->main, &node->qnode);
+			hash_ruc(cache->table, &node->hnode, bucket);
+		}
+		return node;
+	}
+
+	cache->stat.misses++;
+	return NULL;
+}
+
+void
+cache_put(struct cache *cache, struct cache_node *node, u64 hash)
+{
+	while (cache->size >= cache->capacity)
+		cache_evict(cache);
+
+	node->hash = hash;
+	node->freq = 0;
+	node->main = 1;
+	hash_add(cache->table, &node->hnode, cache_bucket(cache, hash));
+
+	if (cache->policy == CACHE_S3FIFO && !cache_ghost_has(cache, hash)) {
+		node->main = 0;
+		list_add(&cache->small, &node->qnode);
+		cache->small_size++;
+	} else {
+		list_add(&cache->main, &node->qnode);
+	}
+
+	cache->size++;
+	cache->stat.inserts++;
+}
@@ -0,0 +1,159 @@
+/*
+ * Bounded key/value cache with LRU and S3-FIFO eviction
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_CACHE_H__
+#define __GENERIC_HASH_CACHE_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list.h>
+#include <bsd/tailq.h>
+#include <bsd/hash/table.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Bounded cache
+ *
+ * The intrusive hash table (hash_add(), hash_ruc(), ...) extended with 
+ * global recency, a capacity and O(1) eviction. Items embed struct cache_node
+ * and are found by their 64-bit hash plus the eq() callback. Evicted items
+ * are handed to the evict() callback which owns them from then on.
+ *
+ * CACHE_LRU
+ *   classic least recently used list, every hit moves the item to the head
+ *
+ * CACHE_S3FIFO
+ *   Yang, Zhang, Qiu, Yue, Vinayak: FIFO queues are all you need for cache 
+ *   eviction. New items go to a small FIFO (10% of capacity) and are 
+ *   promoted to the main FIFO only when hit again before they leave it, so 
+ *   one-hit wonders and scans do not flush the working set. Hashes of items 
+ *   evicted from the small FIFO are remembered in a ghost table and go 
+ *   straight to the main FIFO when they come back. Hits only bump a 2-bit 
+ *   counter and never write to the lists.
+ */
+
+enum cache_policy {
+	CACHE_LRU    = 1,
+	CACHE_S3FIFO = 2,
+};
+
+struct cache_node {
+	struct qnode hnode;   /* hash bucket chain                         */
+	struct node qnode;    /* recency list or FIFO                      */
+	u64 hash;
+	u8 freq;
+	u8 main;              /* in main FIFO                              */
+};
+
+struct cache_stat {
+	u64 hits;
+	u64 misses;
+	u64 inserts;
+	u64 evictions;
+};
+
+struct cache {
+	struct mm *mm;
+	struct tailq *table;
+	unsigned int bits;
+	enum cache_policy policy;
+	struct list main;     /* LRU list or main FIFO                     */
+	struct list small;    /* small FIFO                                */
+	u64 size, capacity;
+	u64 small_size, small_capacity;
+	u64 *ghost;           /* hashes evicted from small FIFO            */
+	u64 *ghost_time;
+	u64 ghost_mask;
+	u64 ghost_clock;
+	int (*eq)(struct cache_node *node, const void *key);
+	void (*evict)(struct cache *cache, struct cache_node *node);
+	struct cache_stat stat;
+};
+
+/*
+ * cache_init - create cache
+ *
+ * @cache:      the cache
+ * @mm:         memory context for the bucket array and ghost table
+ * @capacity:   maximum number of items
+ * @policy:     CACHE_LRU or CACHE_S3FIFO
+ * @eq:         returns non-zero when node matches key
+ * @evict:      called for every item removed by the cache, optional
+ */
+
+void
+cache_init(struct cache *cache, struct mm *mm, u64 capacity, 
+           enum cache_policy policy,
+           int (*eq)(struct cache_node *node, const void *key),
+           void (*evict)(struct cache *cache, struct cache_node *node));
+
+/* evicts all items and frees the cache memory */
+void
+cache_fini(struct cache *cache);
+
+/*
+ * cache_get - find item and record the hit
+ *
+ * Returns the node or NULL when @key is not cached.
+ */
+
+struct cache_node *
+cache_get(struct cache *cache, u64 hash, const void *key);
+
+/*
+ * cache_put - insert item, evicting another one when the cache is full
+ *
+ * The caller makes sure the key is not cached yet (cache_get() missed).
+ */
+
+void
+cache_put(struct cache *cache, struct cache_node *node, u64 hash);
+
+/* remove item without calling evict() */
+void
+cache_del(struct cache *cache, struct cache_node *node);
+
+static inline u64
+cache_size(const struct cache *cache)
+{
+	return cache->size;
+}
+
+static inline double
+cache_hit_ratio(const struct cache *cache)
+{
+	u64 total = cache->stat.hits + cache->stat.misses;
+	return total ? (double)cache->stat.hits / total : 0;
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * Count-min sketch with top-k heavy hitters
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/cms.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void
+cms_init(struct cms *cms, struct mm *mm, double eps, double delta, 
+         unsigned int topk)
+{
+	u32 width = 1, need = (u32)ceil(2.718281828459045 / eps);
+	while (width < need)
+		width <<= 1;
+
+	memset(cms, 0, sizeof(*cms));
+	cms->mm = mm;
+	cms->mask = width - 1;
+	cms->depth = (unsigned int)__max(1, ceil(log(1.0 / delta)));
+	cms->depth = __min(cms->depth, CMS_MAX_DEPTH);
+	cms->counters = mm_alloc(mm, (size_t)width * cms->depth * sizeof(u32));
+	cms->top_max = topk;
+	if (topk)
+		cms->top = mm_alloc(mm, topk * sizeof(*cms->top));
+	cms_reset(cms);
+}
+
+void
+cms_fini(struct cms *cms)
+{
+	mm_free(cms->mm, cms->counters);
+	if (cms->top)
+		mm_free(cms->mm, cms->top);
+	cms->counters = NULL;
+	cms->top = NULL;
+}
+
+void
+cms_reset(struct cms *cms)
+{
+	memset(cms->counters, 0, 
+	       (size_t)(cms->mask + 1) * cms->depth * sizeof(u32));
+	cms->total = 0;
+	cms->top_len = 0;
+}
+
+static void
+cms_sift_down(struct cms_item *heap, unsigned int len, unsigned int i)
+{
+	struct cms_item x = heap[i];
+	for (unsigned int child; (child = 2 * i + 1) < len; i = child) {
+		if (child + 1 < len && heap[child + 1].count < heap[child].count)
+			child++;
+		if (x.count <= heap[child].count)
+			break;
+		heap[i] = heap[child];
+	}
+	heap[i] = x;
+}
+
+static void
+cms_sift_up(struct cms_item *heap, unsigned int i)
+{
+	struct cms_item x = heap[i];
+	for (unsigned int parent; i && x.count < heap[parent = (i - 1) / 2].count;
+	     i = parent)
+		heap[i] = heap[parent];
+	heap[i] = x;
+}
+
+void
+cms_topk_update(struct cms *cms, u64 key, u64 count)
+{
+	struct cms_item *heap = cms->top;
+	for (unsigned int i = 0; i < cms->top_len; i++) {
+		if (heap[i].key != key)
+			continue;
+		/* estimates never decrease */
+		if (heap[i].count < count) {
+			heap[i].count = count;
+			cms_sift_down(heap, cms->top_len, i);
+		}
+		return;
+	}
+
+	if (cms->top_len < cms->top_max) {
+		heap[cms->top_len] = (struct cms_item) {.key = key, .count = count};
+		cms_sift_up(heap, cms->top_len++);
+	} else if (count > heap[0].count) {
+		heap[0] = (struct cms_item) {.key = key, .count = count};
+		cms_sift_down(heap, cms->top_len, 0);
+	}
+}
+
+unsigned int
+cms_topk(struct cms *cms, struct cms_item *items)
+{
+	unsigned int len = cms->top_len;
+	memcpy(items, cms->top, len * sizeof(*items));
+	/* heap sort of the copy, the minimum goes to the end */
+	for (unsigned int n = len; n > 1; n--) {
+		struct cms_item x = items[0];
+		items[0] = items[n - 1];
+		items[n - 1] = x;
+		cms_sift_down(items, n - 1, 0);
+	}
+	return len;
+}
+
+void
+cms_merge(struct cms *dst, struct cms *src)
+{
+	assert(dst->mask == src->mask && dst->depth == src->depth);
+	size_t i = 0, n = (size_t)(dst->mask + 1) * dst->depth;
+	u32 *a = dst->counters, *b = src->counters;
+#ifdef __SSE2__
+	/* saturating add: a + b, or ~0 when it wraps */
+	const __m128i bias = _mm_set1_epi32((int)0x80000000);
+	for (; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i s = _mm_add_epi32(x, y);
+		__m128i wrap = _mm_cmpgt_epi32(_mm_xor_si128(x, bias),
+		                               _mm_xor_si128(s, bias));
+		_mm_storeu_si128((__m128i *)(a + i), _mm_or_si128(s, wrap));
+	}
+#endif
+	for (; i < n; i++)
+		a[i] = a[i] + b[i] < a[i] ? ~0U : a[i] + b[i];
+
+	dst->total += src->total;
+	/* every count of dst grew, not only those of the keys src knows */
+	for (unsigned int j = 0; j < dst->top_len; j++)
+		dst->top[j].count = cms_estimate(dst, dst->top[j].key);
+	for (unsigned int j = dst->top_len / 2; j-- > 0; )
+		cms_sift_down(dst->top, dst->top_len, j);
+	for (unsigned int j = 0; j < src->top_len; j++) {
+		u64 key = src->top[j].key;
+		if (dst->top_max)
+			cms_topk_update(dst, key, cms_estimate(dst, key));
+	}
+}
@@ -0,0 +1,164 @@
+/*
+ * Count-min sketch with top-k heavy hitters
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_CMS_H__
+#define __GENERIC_HASH_CMS_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Count-min sketch
+ *
+ * Cormode, Muthukrishnan: An improved data stream summary: the count-min 
+ * sketch and its applications
+ *
+ * Estimates the frequency of keys in fixed memory, the estimate never under
+ * counts and over counts by at most eps * total with probability 1 - delta.
+ * Keys are given by their 64-bit hash, the row indexes are derived from it
+ * by double hashing. Sketches of the same shape are merged by adding the 
+ * counters.
+ *
+ * The optional top-k keeps the k keys with the highest estimate in a 
+ * min-heap; the heap is looked at only when an estimate reaches its minimum,
+ * so the cost of light keys is just the sketch update.
+ */
+
+#define CMS_MAX_DEPTH 16
+
+struct cms_item {
+	u64 key;
+	u64 count;
+};
+
+struct cms {
+	struct mm *mm;
+	u32 *counters;        /* depth rows of width counters              */
+	u64 total;
+	u32 mask;             /* width - 1                                 */
+	unsigned int depth;
+	struct cms_item *top; /* min-heap of heavy hitters                 */
+	unsigned int top_len;
+	unsigned int top_max;
+};
+
+/*
+ * cms_init - create sketch
+ *
+ * @cms:        the sketch
+ * @mm:         memory context
+ * @eps:        error as a fraction of the total count
+ * @delta:      probability of exceeding the error
+ * @topk:       number of heavy hitters to track or 0
+ */
+
+void
+cms_init(struct cms *cms, struct mm *mm, double eps, double delta, 
+         unsigned int topk);
+
+void
+cms_fini(struct cms *cms);
+
+void
+cms_reset(struct cms *cms);
+
+/*
+ * cms_merge - add counters of @src to @dst, both of the same shape 
+ *
+ * The heavy hitters of @src are offered to @dst with their merged estimate.
+ */
+
+void
+cms_merge(struct cms *dst, struct cms *src);
+
+void
+cms_topk_update(struct cms *cms, u64 key, u64 count);
+
+/*
+ * cms_topk - heavy hitters sorted by count in descending order
+ *
+ * Returns the number of items stored to @items, at most the topk given to 
+ * cms_init().
+ */
+
+unsigned int
+cms_topk(struct cms *cms, struct cms_item *items);
+
+static inline u32
+cms_index(const struct cms *cms, u64 hash, unsigned int row)
+{
+	u32 a = (u32)hash, b = (u32)(hash >> 32) | 1;
+	return (a + row * b) & cms->mask;
+}
+
+static inline u64
+cms_estimate(const struct cms *cms, u64 hash)
+{
+	u32 width = cms->mask + 1, min = ~0U;
+	for (unsigned int row = 0; row < cms->depth; row++) {
+		u32 c = cms->counters[(size_t)row * width + cms_index(cms, hash, row)];
+		min = __min(min, c);
+	}
+	return min;
+}
+
+/*
+ * cms_add - count key @hash @count times
+ *
+ * Uses conservative update, only the counters below the new estimate are 
+ * raised. Returns the new estimate.
+ */
+
+static inline u64
+cms_add(struct cms *cms, u64 hash, u32 count)
+{
+	u32 width = cms->mask + 1, *c[CMS_MAX_DEPTH], min = ~0U;
+	for (unsigned int row = 0; row < cms->depth; row++) {
+		c[row] = cms->counters + (size_t)row * width + cms_index(cms, hash, row);
+		min = __min(min, *c[row]);
+	}
+
+	u32 estimate = min + count < min ? ~0U : min + count;
+	for (unsigned int row = 0; row < cms->depth; row++)
+		if (*c[row] < estimate)
+			*c[row] = estimate;
+
+	cms->total += count;
+	if (cms->top_max && (cms->top_len < cms->top_max ||
+	    estimate > cms->top[0].count))
+		cms_topk_update(cms, hash, estimate);
+	return estimate;
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Consistent hashing: jump, rendezvous and bounded-load routing
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/consistent.h>
+#include <math.h>
+
+void
+hash_bounded_init(struct hash_bounded *bounded, struct mm *mm, u32 count, 
+                  double eps)
+{
+	bounded->mm = mm;
+	bounded->count = __max(count, 1);
+	bounded->eps = eps;
+	bounded->keys = 0;
+	bounded->load = mm_zalloc(mm, bounded->count * sizeof(u64));
+}
+
+void
+hash_bounded_fini(struct hash_bounded *bounded)
+{
+	mm_free(bounded->mm, bounded->load);
+	bounded->load = NULL;
+}
+
+u32
+hash_bounded_add(struct hash_bounded *bounded, u64 key)
+{
+	double avg = (double)(bounded->keys + 1) / bounded->count;
+	u64 cap = (u64)ceil((1.0 + bounded->eps) * avg);
+	u32 node = hash_jump(key, bounded->count);
+
+	/* the probe sequence is fixed per key, the total capacity exceeds keys */
+	for (u64 i = 1; bounded->load[node] >= cap; i++)
+		node = hash_jump(hash_u64(key + i, 64), bounded->count);
+
+	bounded->load[node]++;
+	bounded->keys++;
+	return node;
+}
@@ -0,0 +1,311 @@
+/*
+ * Consistent hashing: jump, rendezvous and bounded-load routing
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_CONSISTENT_H__
+#define __GENERIC_HASH_CONSISTENT_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/hash/fn.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Consistent hashing
+ *
+ * hash_u64(x, bits) % n moves almost every key when n changes. The functions
+ * below take the 64-bit outputs of hash_u64(), hash_buffer(), ... and move 
+ * only about 1/n of the keys when a node is added or removed.
+ *
+ * hash_jump()
+ *   Lamping, Veach: A Fast, Minimal Memory, Consistent Hash Algorithm. 
+ *   No state, O(ln n), but nodes are numbered 0..n-1 and only the last one 
+ *   can be removed.
+ *
+ * hash_rendezvous(), hash_rendezvous_weighted()
+ *   Thaler, Ravishankar: highest random weight. Every node scores the key 
+ *   and the highest score wins, so any node can be removed. O(n), scored 8 
+ *   nodes at a time with AVX2. Nodes are identified by 32-bit seeds, use 
+ *   hash_u32(id, 32) of stable node ids. The weighted variant scores 
+ *   w / -log2(u) (Schindelhauer, Schomaker) with a polynomial log2 shared by
+ *   the scalar and SIMD paths, so builds with and without AVX2 agree.
+ *
+ * struct hash_bounded
+ *   Mirrokni, Thorup, Zadimoghaddam: Consistent Hashing with Bounded Loads. 
+ *   No node takes more than ceil((1 + eps) * keys / n) keys, a key probes the
+ *   jump hash of its rehashed value until it finds a node with free capacity.
+ */
+
+static inline u32
+hash_jump(u64 key, u32 buckets)
+{
+	s64 b = -1, j = 0;
+	while (j < buckets) {
+		b = j;
+		key = key * 2862933555777941757ULL + 1;
+		j = (s64)((b + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1)));
+	}
+	return (u32)b;
+}
+
+static inline u32
+hash_rendezvous_key(u64 key)
+{
+	return (u32)(key >> 32) ^ (u32)key;
+}
+
+static inline u32
+hash_rendezvous_score(u32 key, u32 seed)
+{
+	u32 x = key ^ seed;
+	x = ((x >> 16) ^ x) * 0x45d9f3b;
+	x = ((x >> 16) ^ x) * 0x45d9f3b;
+	return (x >> 16) ^ x;
+}
+
+/*
+ * log2(x) for x in (0, 1] with small relative error near 1, where the 
+ * winning scores come from. x = 2^e * m, m in [sqrt(1/2), sqrt(2)) and
+ * ln(m) = 2 atanh((m - 1) / (m + 1)) as odd series. The scalar and SIMD 
+ * paths do the same float operations in the same order.
+ */
+
+static inline float
+hash_rendezvous_log2(float x)
+{
+	union { float f; u32 u; } v = { .f = x };
+	s32 e = (s32)(v.u >> 23) - 127;
+	v.u = (v.u & 0x007fffff) | 0x3f800000;
+	float m = v.f;
+	if (m > 1.41421356f) {
+		m = m * 0.5f;
+		e = e + 1;
+	}
+	float s = (m - 1.0f) / (m + 1.0f);
+	float s2 = s * s;
+	float p = 0.11111111f;
+	p = p * s2;  p = p + 0.14285714f;
+	p = p * s2;  p = p + 0.2f;
+	p = p * s2;  p = p + 0.33333333f;
+	p = p * s2;  p = p + 1.0f;
+	p = p * s;   p = p * 2.88539008f;    /* 2 / ln(2) */
+	return (float)e + p;
+}
+
+static inline float
+hash_rendezvous_wscore(u32 score, float weight)
+{
+	/* uniform (0, 1) from the top 24 bits */
+	float u = ((float)(score >> 8) + 0.5f) * (1.0f / 16777216.0f);
+	float l = hash_rendezvous_log2(u);
+	return weight / (0.0f - l);
+}
+
+#ifdef __AVX2__
+static inline __m256i
+__hash_rendezvous_score8(__m256i key, __m256i seed)
+{
+	__m256i c = _mm256_set1_epi32(0x45d9f3b);
+	__m256i x = _mm256_xor_si256(key, seed);
+	x = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srli_epi32(x, 16), x), c);
+	x = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srli_epi32(x, 16), x), c);
+	return _mm256_xor_si256(_mm256_srli_epi32(x, 16), x);
+}
+
+static inline __m256
+__hash_rendezvous_log2x8(__m256 x)
+{
+	__m256i v = _mm256_castps_si256(x);
+	__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(v, 23), 
+	                             _mm256_set1_epi32(127));
+	v = _mm256_or_si256(_mm256_and_si256(v, _mm256_set1_epi32(0x007fffff)),
+	                    _mm256_set1_epi32(0x3f800000));
+	__m256 m = _mm256_castsi256_ps(v);
+	__m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+	e = _mm256_sub_epi32(e, _mm256_castps_si256(big));
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+	__m256 s2 = _mm256_mul_ps(s, s);
+	__m256 p = _mm256_set1_ps(0.11111111f);
+	p = _mm256_mul_ps(p, s2);  p = _mm256_add_ps(p, _mm256_set1_ps(0.14285714f));
+	p = _mm256_mul_ps(p, s2);  p = _mm256_add_ps(p, _mm256_set1_ps(0.2f));
+	p = _mm256_mul_ps(p, s2);  p = _mm256_add_ps(p, _mm256_set1_ps(0.33333333f));
+	p = _mm256_mul_ps(p, s2);  p = _mm256_add_ps(p, one);
+	p = _mm256_mul_ps(p, s);   p = _mm256_mul_ps(p, _mm256_set1_ps(2.88539008f));
+	return _mm256_add_ps(_mm256_cvtepi32_ps(e), p);
+}
+#endif
+
+/**
+ * hash_rendezvous - pick node with the highest random weight
+ *
+ * @key:        64-bit key hash
+ * @seed:       node seeds
+ * @count:      number of nodes, at least 1
+ *
+ * Returns index of the node, ties go to the lower index.
+ */
+
+static inline u32
+hash_rendezvous(u64 key, const u32 *seed, u32 count)
+{
+	u32 k = hash_rendezvous_key(key), best = 0, top = 0, i = 0;
+#ifdef __AVX2__
+	if (count >= 8) {
+		__m256i vk = _mm256_set1_epi32((int)k);
+		__m256i flip = _mm256_set1_epi32((int)0x80000000);
+		__m256i max = _mm256_set1_epi32((int)0x80000000);
+		__m256i idx = _mm256_setzero_si256();
+		__m256i cur = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (; i + 8 <= count; i += 8) {
+			__m256i s = _mm256_loadu_si256((const __m256i *)(seed + i));
+			/* signed compare of biased scores is unsigned compare */
+			s = _mm256_xor_si256(__hash_rendezvous_score8(vk, s), flip);
+			__m256i gt = _mm256_cmpgt_epi32(s, max);
+			max = _mm256_blendv_epi8(max, s, gt);
+			idx = _mm256_blendv_epi8(idx, cur, gt);
+			cur = _mm256_add_epi32(cur, _mm256_set1_epi32(8));
+		}
+		u32 m[8], x[8];
+		_mm256_storeu_si256((__m256i *)m, max);
+		_mm256_storeu_si256((__m256i *)x, idx);
+		top = m[0] ^ 0x80000000; best = x[0];
+		for (unsigned int j = 1; j < 8; j++) {
+			u32 s = m[j] ^ 0x80000000;
+			if (s > top || (s == top && x[j] < best))
+				top = s, best = x[j];
+		}
+	} else
+#endif
+	top = hash_rendezvous_score(k, seed[i++]);
+
+	for (; i < count; i++) {
+		u32 s = hash_rendezvous_score(k, seed[i]);
+		if (s > top)
+			top = s, best = i;
+	}
+	return best;
+}
+
+/**
+ * hash_rendezvous_weighted - weighted highest random weight
+ *
+ * @key:        64-bit key hash
+ * @seed:       node seeds
+ * @weight:     node weights, > 0
+ * @count:      number of nodes, at least 1
+ *
+ * Node i gets weight[i] / sum(weight) of the keys.
+ */
+
+static inline u32
+hash_rendezvous_weighted(u64 key, const u32 *seed, const float *weight, 
+                         u32 count)
+{
+	u32 k = hash_rendezvous_key(key), best = 0, i = 0;
+	float top = -1.0f;
+#ifdef __AVX2__
+	if (count >= 8) {
+		__m256i vk = _mm256_set1_epi32((int)k);
+		__m256 max = _mm256_set1_ps(-1.0f);
+		__m256i idx = _mm256_setzero_si256();
+		__m256i cur = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (; i + 8 <= count; i += 8) {
+			__m256i s = _mm256_loadu_si256((const __m256i *)(seed + i));
+			s = __hash_rendezvous_score8(vk, s);
+			__m256 u = _mm256_cvtepi32_ps(_mm256_srli_epi32(s, 8));
+			u = _mm256_add_ps(u, _mm256_set1_ps(0.5f));
+			u = _mm256_mul_ps(u, _mm256_set1_ps(1.0f / 16777216.0f));
+			__m256 l = __hash_rendezvous_log2x8(u);
+			l = _mm256_sub_ps(_mm256_setzero_ps(), l);
+			__m256 w = _mm256_div_ps(_mm256_loadu_ps(weight + i), l);
+			__m256 gt = _mm256_cmp_ps(w, max, _CMP_GT_OQ);
+			max = _mm256_blendv_ps(max, w, gt);
+			idx = _mm256_blendv_epi8(idx, cur, _mm256_castps_si256(gt));
+			cur = _mm256_add_epi32(cur, _mm256_set1_epi32(8));
+		}
+		float m[8]; u32 x[8];
+		_mm256_storeu_ps(m, max);
+		_mm256_storeu_si256((__m256i *)x, idx);
+		top = m[0]; best = x[0];
+		for (unsigned int j = 1; j < 8; j++)
+			if (m[j] > top || (m[j] == top && x[j] < best))
+				top = m[j], best = x[j];
+	}
+#endif
+	for (; i < count; i++) {
+		float s = hash_rendezvous_wscore(hash_rendezvous_score(k, seed[i]), 
+		                                 weight[i]);
+		if (s > top)
+			top = s, best = i;
+	}
+	return best;
+}
+
+struct hash_bounded {
+	struct mm *mm;
+	u64 *load;            /* keys per node                             */
+	u64 keys;             /* keys assigned                             */
+	u32 count;            /* nodes                                     */
+	double eps;           /* allowed overload                          */
+};
+
+/*
+ * hash_bounded_init - bounded-load router
+ *
+ * @bounded:    the router
+ * @mm:         memory context
+ * @count:      number of nodes
+ * @eps:        capacity of a node is ceil((1 + eps) * average load)
+ */
+
+void
+hash_bounded_init(struct hash_bounded *bounded, struct mm *mm, u32 count, 
+                  double eps);
+
+void
+hash_bounded_fini(struct hash_bounded *bounded);
+
+/* returns node for a new key and accounts it */
+u32
+hash_bounded_add(struct hash_bounded *bounded, u64 key);
+
+/* key previously added to node is gone */
+static inline void
+hash_bounded_del(struct hash_bounded *bounded, u32 node)
+{
+	bounded->load[node]--;
+	bounded->keys--;
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Cuckoo filter
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/cuckoo.h>
+#include <string.h>
+#include <math.h>
+
+int
+cuckoo_init(struct cuckoo *cuckoo, struct mm *mm, u64 keys, double fpp)
+{
+	if (!(fpp > 0 && fpp < 1))
+		return -1;
+
+	/* 
+	 * fingerprint needs log2(2 * slots / fpp) bits, rounded up to the slot 
+	 * width, bits between 8 and 16 would be wasted in a 16 bit slot
+	 */
+	double bits = ceil(log2(2.0 * CUCKOO_SLOTS / fpp));
+	unsigned int width = bits > 8 ? 2 : 1;
+
+	/* load factor of 95% is reachable with 4 slots per bucket */
+	u64 buckets = (u64)ceil(keys / (0.95 * CUCKOO_SLOTS));
+	u64 n = 1;
+	while (n < buckets)
+		n <<= 1;
+
+	memset(cuckoo, 0, sizeof(*cuckoo));
+	cuckoo->mm = mm;
+	cuckoo->mask = n - 1;
+	cuckoo->fpmask = width == 2 ? 0xffff : 0xff;
+	cuckoo->width = width;
+	cuckoo->seed = 0x9e3779b97f4a7c15ULL;
+	cuckoo->table = mm_alloc(mm, cuckoo_size(cuckoo));
+	memset(cuckoo->table, 0, cuckoo_size(cuckoo));
+	return 0;
+}
+
+void
+cuckoo_fini(struct cuckoo *cuckoo)
+{
+	mm_free(cuckoo->mm, cuckoo->table);
+	cuckoo->table = NULL;
+}
+
+static int
+cuckoo_put(struct cuckoo *cuckoo, u64 index, u32 fp)
+{
+	for (unsigned int slot = 0; slot < CUCKOO_SLOTS; slot++) {
+		if (cuckoo_get(cuckoo, index, slot))
+			continue;
+		cuckoo_set(cuckoo, index, slot, fp);
+		return 0;
+	}
+	return -1;
+}
+
+int
+cuckoo_add(struct cuckoo *cuckoo, u64 hash)
+{
+	if (cuckoo->victim)
+		return -1;
+
+	u32 fp = cuckoo_fp(cuckoo, hash);
+	u64 index = cuckoo_index(cuckoo, hash);
+	u64 alt = cuckoo_alt_index(cuckoo, index, fp);
+
+	if (!cuckoo_put(cuckoo, index, fp) || !cuckoo_put(cuckoo, alt, fp))
+		goto done;
+
+	index = (cuckoo->seed & 1) ? index : alt;
+	for (unsigned int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+		cuckoo->seed ^= cuckoo->seed << 13;
+		cuckoo->seed ^= cuckoo->seed >> 7;
+		cuckoo->seed ^= cuckoo->seed << 17;
+
+		unsigned int slot = cuckoo->seed % CUCKOO_SLOTS;
+		u32 evicted = cuckoo_get(cuckoo, index, slot);
+		cuckoo_set(cuckoo, index, slot, fp);
+		fp = evicted;
+		index = cuckoo_alt_index(cuckoo, index, fp);
+		if (!cuckoo_put(cuckoo, index, fp))
+			goto done;
+	}
+
+	cuckoo->victim = 1;
+	cuckoo->victim_fp = fp;
+	cuckoo->victim_index = index;
+done:
+	cuckoo->items++;
+	return cuckoo->victim ? -1 : 0;
+}
+
+static int
+cuckoo_drop(struct cuckoo *cuckoo, u64 index, u32 fp)
+{
+	for (unsigned int slot = 0; slot < CUCKOO_SLOTS; slot++) {
+		if (cuckoo_get(cuckoo, index, slot) != fp)
+			continue;
+		cuckoo_set(cuckoo, index, slot, 0);
+		return 0;
+	}
+	return -1;
+}
+
+int
+cuckoo_del(struct cuckoo *cuckoo, u64 hash)
+{
+	u32 fp = cuckoo_fp(cuckoo, hash);
+	u64 i1 = cuckoo_index(cuckoo, hash);
+	u64 i2 = cuckoo_alt_index(cuckoo, i1, fp);
+
+	if (cuckoo->victim && cuckoo->victim_fp == fp &&
+	   (cuckoo->victim_index == i1 || cuckoo->victim_index == i2)) {
+		cuckoo->victim = 0;
+		goto done;
+	}
+
+	if (cuckoo_drop(cuckoo, i1, fp) && cuckoo_drop(cuckoo, i2, fp))
+		return -1;
+
+	/* a slot is free now, try to place the stashed fingerprint again */
+	if (cuckoo->victim) {
+		u64 index = cuckoo->victim_index;
+		u64 alt = cuckoo_alt_index(cuckoo, index, cuckoo->victim_fp);
+		if (!cuckoo_put(cuckoo, index, cuckoo->victim_fp) ||
+		    !cuckoo_put(cuckoo, alt, cuckoo->victim_fp))
+			cuckoo->victim = 0;
+	}
+done:
+	cuckoo->items--;
+	return 0;
+}
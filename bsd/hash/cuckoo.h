@@ -0,0 +1,177 @@
+/*
+ * Cuckoo filter
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_CUCKOO_H__
+#define __GENERIC_HASH_CUCKOO_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/hash/fn.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Cuckoo filter
+ *
+ * Fan, Andersen, Kaminsky, Mitzenmacher: Cuckoo Filter: Practically Better 
+ * Than Bloom
+ *
+ * Approximate set membership with deletion. Each key is reduced to a short
+ * fingerprint stored in one of two buckets of four slots; the alternate 
+ * bucket is computed from the fingerprint alone (partial-key cuckoo hashing)
+ * so entries can be relocated without knowing the original key.
+ *
+ * Keys are given by their 64-bit hash: the upper half selects the bucket, 
+ * the lower half provides the fingerprint. Fingerprints are 8 or 16 bits 
+ * wide depending on the requested false positive probability.
+ *
+ * Only keys which were added may be deleted, otherwise another key sharing
+ * the fingerprint is silently removed.
+ */
+
+#define CUCKOO_SLOTS     4
+#define CUCKOO_MAX_KICKS 500
+
+struct cuckoo {
+	struct mm *mm;
+	void *table;          /* buckets of CUCKOO_SLOTS fingerprints      */
+	u64 mask;             /* number of buckets - 1                     */
+	u64 items;            /* number of stored fingerprints             */
+	u64 seed;             /* victim selection                          */
+	u32 fpmask;           /* fingerprint bits                          */
+	u32 victim_fp;        /* fingerprint which did not fit, if any     */
+	u64 victim_index;
+	unsigned int width;   /* bytes per fingerprint, 1 or 2             */
+	unsigned int victim;
+};
+
+/*
+ * cuckoo_init - create filter for expected number of keys
+ *
+ * @cuckoo:     the filter
+ * @mm:         memory context
+ * @keys:       expected number of keys
+ * @fpp:        target false positive probability
+ *
+ * Returns 0 on success or -1 when @fpp is not between 0 and 1.
+ */
+
+int
+cuckoo_init(struct cuckoo *cuckoo, struct mm *mm, u64 keys, double fpp);
+
+void
+cuckoo_fini(struct cuckoo *cuckoo);
+
+/*
+ * cuckoo_add - add key
+ *
+ * Returns 0 on success or -1 when the filter is full. The key is still 
+ * remembered after a failure (no false negatives) but no other key can be 
+ * added until something is deleted.
+ */
+
+int
+cuckoo_add(struct cuckoo *cuckoo, u64 hash);
+
+int
+cuckoo_del(struct cuckoo *cuckoo, u64 hash);
+
+/* size of the filter in bytes */
+static inline size_t
+cuckoo_size(const struct cuckoo *cuckoo)
+{
+	return (size_t)(cuckoo->mask + 1) * CUCKOO_SLOTS * cuckoo->width;
+}
+
+static inline u32
+cuckoo_fp(const struct cuckoo *cuckoo, u64 hash)
+{
+	u32 fp = (u32)hash & cuckoo->fpmask;
+	return fp ? fp : 1;
+}
+
+static inline u64
+cuckoo_index(const struct cuckoo *cuckoo, u64 hash)
+{
+	return (hash >> 32) & cuckoo->mask;
+}
+
+static inline u64
+cuckoo_alt_index(const struct cuckoo *cuckoo, u64 index, u32 fp)
+{
+	return (index ^ hash_u64(fp, 64)) & cuckoo->mask;
+}
+
+static inline u32
+cuckoo_get(const struct cuckoo *cuckoo, u64 index, unsigned int slot)
+{
+	size_t i = (size_t)index * CUCKOO_SLOTS + slot;
+	if (cuckoo->width == 1)
+		return ((u8 *)cuckoo->table)[i];
+	return ((u16 *)cuckoo->table)[i];
+}
+
+static inline void
+cuckoo_set(struct cuckoo *cuckoo, u64 index, unsigned int slot, u32 fp)
+{
+	size_t i = (size_t)index * CUCKOO_SLOTS + slot;
+	if (cuckoo->width == 1)
+		((u8 *)cuckoo->table)[i] = (u8)fp;
+	else
+		((u16 *)cuckoo->table)[i] = (u16)fp;
+}
+
+static inline int
+cuckoo_bucket_has(const struct cuckoo *cuckoo, u64 index, u32 fp)
+{
+	size_t i = (size_t)index * CUCKOO_SLOTS;
+	if (cuckoo->width == 1) {
+		const u8 *b = (const u8 *)cuckoo->table + i;
+		return (b[0] == fp) | (b[1] == fp) | (b[2] == fp) | (b[3] == fp);
+	} 
+	const u16 *b = (const u16 *)cuckoo->table + i;
+	return (b[0] == fp) | (b[1] == fp) | (b[2] == fp) | (b[3] == fp);
+}
+
+static inline int
+cuckoo_test(const struct cuckoo *cuckoo, u64 hash)
+{
+	u32 fp = cuckoo_fp(cuckoo, hash);
+	u64 i1 = cuckoo_index(cuckoo, hash);
+	u64 i2 = cuckoo_alt_index(cuckoo, i1, fp);
+	if (cuckoo_bucket_has(cuckoo, i1, fp) | cuckoo_bucket_has(cuckoo, i2, fp))
+		return 1;
+	return cuckoo->victim && cuckoo->victim_fp == fp && 
+	       (cuckoo->victim_index == i1 || cuckoo->victim_index == i2);
+}
+
+__END_DECLS
+
+#endif
@@ -37,6 +37,13 @@
 #endif
 #include "xxhash.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 static inline u64
 hash_u64(u64 x, unsigned int bits)
 {
@@ -46,6 +53,67 @@ hash_u64(u64 x, unsigned int bits)
 	return x >> (64 - bits);
 }
 
+#ifdef __AVX2__
+/* 64-bit lane multiply by constant, AVX2 has only 32x32->64 vpmuludq */
+static inline __m256i
+__hash_mul64x4(__m256i x, u64 c)
+{
+	__m256i lo = _mm256_mul_epu32(x, _mm256_set1_epi64x(c));
+	__m256i a  = _mm256_mul_epu32(_mm256_srli_epi64(x, 32),
+	                              _mm256_set1_epi64x(c));
+	__m256i b  = _mm256_mul_epu32(x, _mm256_set1_epi64x(c >> 32));
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(_mm256_add_epi64(a, b), 32));
+}
+#endif
+
+/**
+ * hash_u64_many - hash a batch of 64-bit keys
+ *
+ * @x:          keys
+ * @hash:       output hashes, same as hash_u64(x[i], bits)
+ * @count:      number of keys
+ * @bits:       hash bits
+ *
+ * The multiply chains of independent keys are interleaved (4 lanes of AVX2 
+ * when available) so that the latency of one key is hidden by the others.
+ */
+
+static inline void
+hash_u64_many(const u64 *x, u64 *hash, unsigned int count, unsigned int bits)
+{
+	unsigned int i = 0;
+#ifdef __AVX2__
+	for (; i + 4 <= count; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+		v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 30));
+		v = __hash_mul64x4(v, 0xbf58476d1ce4e5b9);
+		v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 27));
+		v = __hash_mul64x4(v, 0x94d049bb133111eb);
+		v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 31));
+		v = _mm256_srli_epi64(v, 64 - bits);
+		_mm256_storeu_si256((__m256i *)(hash + i), v);
+	}
+#else
+	for (; i + 4 <= count; i += 4) {
+		u64 a = x[i], b = x[i + 1], c = x[i + 2], d = x[i + 3];
+		a = (a ^ (a >> 30)) * (u64)(0xbf58476d1ce4e5b9);
+		b = (b ^ (b >> 30)) * (u64)(0xbf58476d1ce4e5b9);
+		c = (c ^ (c >> 30)) * (u64)(0xbf58476d1ce4e5b9);
+		d = (d ^ (d >> 30)) * (u64)(0xbf58476d1ce4e5b9);
+		a = (a ^ (a >> 27)) * (u64)(0x94d049bb133111eb);
+		b = (b ^ (b >> 27)) * (u64)(0x94d049bb133111eb);
+		c = (c ^ (c >> 27)) * (u64)(0x94d049bb133111eb);
+		d = (d ^ (d >> 27)) * (u64)(0x94d049bb133111eb);
+		hash[i]     = (a ^ (a >> 31)) >> (64 - bits);
+		hash[i + 1] = (b ^ (b >> 31)) >> (64 - bits);
+		hash[i + 2] = (c ^ (c >> 31)) >> (64 - bits);
+		hash[i + 3] = (d ^ (d >> 31)) >> (64 - bits);
+	}
+#endif
+	for (; i < count; i++)
+		hash[i] = hash_u64(x[i], bits);
+}
+
 static inline u32
 hash_u32(u32 x, unsigned int bits)
 {
@@ -110,17 +178,159 @@ hash_buffer(const u8 *ptr, unsigned int size)
     return hash;
 }
 
+/**
+ * hash_buffer_many - hash a batch of equal-length buffers
+ *
+ * @ptr:        buffers
+ * @size:       size of each buffer
+ * @hash:       output hashes, same as hash_buffer(ptr[i], size)
+ * @count:      number of buffers
+ *
+ * Four buffers are processed together, stripe by stripe, so the xxh64 rounds
+ * of different keys overlap in the pipeline.
+ */
+
+static inline void
+hash_buffer_many(const u8 **ptr, unsigned int size, unsigned long long *hash,
+                 unsigned int count)
+{
+	unsigned int i = 0;
+#if CPU_ARCH_BITS == 64
+	unsigned int stripes = size >> 5;
+	for (; stripes && i + 4 <= count; i += 4) {
+		u64 v[4][4], h;
+		for (unsigned int k = 0; k < 4; k++) {
+			v[k][0] = PRIME64_1 + PRIME64_2;
+			v[k][1] = PRIME64_2;
+			v[k][2] = 0;
+			v[k][3] = 0 - PRIME64_1;
+		}
+		for (unsigned int s = 0; s < stripes; s++) {
+			for (unsigned int k = 0; k < 4; k++) {
+				const u8 *p = ptr[i + k] + (s << 5);
+				v[k][0] = XXH64_round(v[k][0], XXH_readLE64(p, XXH_littleEndian));
+				v[k][1] = XXH64_round(v[k][1], XXH_readLE64(p + 8, XXH_littleEndian));
+				v[k][2] = XXH64_round(v[k][2], XXH_readLE64(p + 16, XXH_littleEndian));
+				v[k][3] = XXH64_round(v[k][3], XXH_readLE64(p + 24, XXH_littleEndian));
+			}
+		}
+		for (unsigned int k = 0; k < 4; k++) {
+			h = XXH_rotl64(v[k][0], 1)  + XXH_rotl64(v[k][1], 7) + 
+			    XXH_rotl64(v[k][2], 12) + XXH_rotl64(v[k][3], 18);
+			h = XXH64_mergeRound(h, v[k][0]);
+			h = XXH64_mergeRound(h, v[k][1]);
+			h = XXH64_mergeRound(h, v[k][2]);
+			h = XXH64_mergeRound(h, v[k][3]);
+			h += (u64)size;
+			hash[i + k] = XXH64_finalize(h, ptr[i + k] + (stripes << 5),
+			              size, XXH_littleEndian, XXH_unaligned);
+		}
+	}
+#endif
+	for (; i < count; i++)
+		hash[i] = hash_buffer(ptr[i], size);
+}
+
 static inline u32
 hash_buffer_u32(const u8 *ptr, unsigned int size, unsigned int bits)
 {
 	return ((u32)hash_buffer(ptr, size)) >> (32 - bits);
 }
 
+/**
+ * hash_string_len - hash NUL-terminated string in a single pass
+ *
+ * @str:        the string
+ * @len:        optional, returns length of the string
+ *
+ * Returns the same value as hash_buffer(str, strlen(str)).
+ *
+ * The terminator is searched with aligned 16 byte loads which never cross a 
+ * page boundary, and every 32 bytes known to precede it are mixed into the 
+ * xxh64 lanes right away, so the string is not read twice. Short strings are
+ * finished from the cache lines the scan has just loaded.
+ */
+
 static inline unsigned long long
-hash_string(const char *str)
+hash_string_len(const char *str, size_t *len)
 {
+#if CPU_ARCH_BITS == 64 && defined(__SSE2__)
+	const u8 *s = (const u8 *)str;
+	const u8 *q = (const u8 *)((uintptr_t)s & ~(uintptr_t)15);
+	const __m128i zero = _mm_setzero_si128();
+	unsigned int m = _mm_movemask_epi8(
+	                 _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)q), zero));
+	m >>= (s - q);
+
+	size_t size, done = 0;
+	u64 v1 = PRIME64_1 + PRIME64_2, v2 = PRIME64_2, v3 = 0, v4 = 0 - PRIME64_1;
+	u64 h64;
+
+	if (likely(m)) {
+		size = __builtin_ctz(m);
+		goto tail;
+	}
+
+	for (q += 16;; q += 32) {
+		m = _mm_movemask_epi8(
+		    _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)q), zero));
+		if (m) {
+			size = (size_t)(q - s) + __builtin_ctz(m);
+			break;
+		}
+		m = _mm_movemask_epi8(
+		    _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)(q + 16)), zero));
+		if (m) {
+			size = (size_t)(q + 16 - s) + __builtin_ctz(m);
+			break;
+		}
+		if ((size_t)(q + 32 - s) - done >= 32) {
+			const u8 *p = s + done;
+			v1 = XXH64_round(v1, XXH_readLE64(p, XXH_littleEndian));
+			v2 = XXH64_round(v2, XXH_readLE64(p + 8, XXH_littleEndian));
+			v3 = XXH64_round(v3, XXH_readLE64(p + 16, XXH_littleEndian));
+			v4 = XXH64_round(v4, XXH_readLE64(p + 24, XXH_littleEndian));
+			done += 32;
+		}
+	}
+
+	for (; size - done >= 32; done += 32) {
+		const u8 *p = s + done;
+		v1 = XXH64_round(v1, XXH_readLE64(p, XXH_littleEndian));
+		v2 = XXH64_round(v2, XXH_readLE64(p + 8, XXH_littleEndian));
+		v3 = XXH64_round(v3, XXH_readLE64(p + 16, XXH_littleEndian));
+		v4 = XXH64_round(v4, XXH_readLE64(p + 24, XXH_littleEndian));
+	}
+
+tail:
+	if (len)
+		*len = size;
+	if (done) {
+		h64 = XXH_rotl64(v1, 1)  + XXH_rotl64(v2, 7) +
+		      XXH_rotl64(v3, 12) + XXH_rotl64(v4, 18);
+		h64 = XXH64_mergeRound(h64, v1);
+		h64 = XXH64_mergeRound(h64, v2);
+		h64 = XXH64_mergeRound(h64, v3);
+		h64 = XXH64_mergeRound(h64, v4);
+	} else {
+		h64 = PRIME64_5;
+	}
+
+	h64 += (u64)size;
+	return XXH64_finalize(h64, s + done, size, 
+	                      XXH_littleEndian, XXH_unaligned);
+#else
 	size_t size = strlen(str);
+	if (len)
+		*len = size;
 	return hash_buffer((u8*)str, size);
+#endif
+}
+
+static inline unsigned long long
+hash_string(const char *str)
+{
+	return hash_string_len(str, NULL);
 }
 
 /* 
@@ -0,0 +1,257 @@
+/*
+ * HyperLogLog cardinality estimator
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/hll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HLL_SPARSE_BITS (HLL_SPARSE_P - 6)
+
+void
+hll_init(struct hll *hll, struct mm *mm, unsigned int p)
+{
+	assert(p >= HLL_P_MIN && p <= HLL_P_MAX);
+	memset(hll, 0, sizeof(*hll));
+	hll->mm = mm;
+	hll->p = p;
+}
+
+void
+hll_fini(struct hll *hll)
+{
+	if (hll->regs)
+		mm_free(hll->mm, hll->regs);
+	if (hll->sparse)
+		mm_free(hll->mm, hll->sparse);
+	hll->regs = NULL;
+	hll->sparse = NULL;
+}
+
+void
+hll_reset(struct hll *hll)
+{
+	if (hll->regs)
+		memset(hll->regs, 0, (size_t)1 << hll->p);
+	hll->sparse_len = hll->tmp_len = 0;
+}
+
+static inline u32
+hll_sparse_encode(u64 hash)
+{
+	u32 index = (u32)(hash >> (64 - HLL_SPARSE_P));
+	u32 rank = __builtin_clzll((hash << HLL_SPARSE_P) | 
+	                           (1ULL << (HLL_SPARSE_P - 1))) + 1;
+	return index << 6 | rank;
+}
+
+/* 
+ * Sparse entries are sorted by index, entries with the same index differ 
+ * only by rank and the higher one wins. 
+ */
+
+static int
+hll_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+	return (x > y) - (x < y);
+}
+
+static void
+hll_dense(struct hll *hll);
+
+static void
+hll_sparse_flush(struct hll *hll)
+{
+	u32 *tmp = hll->tmp, n = hll->tmp_len;
+	qsort(tmp, n, sizeof(*tmp), hll_cmp_u32);
+
+	u32 cap = hll->sparse_len + n;
+	if (cap > hll->sparse_cap) {
+		cap = __max(cap, hll->sparse_cap * 2);
+		u32 *sparse = mm_alloc(hll->mm, cap * sizeof(u32));
+		if (hll->sparse_len)
+			memcpy(sparse, hll->sparse, hll->sparse_len * sizeof(u32));
+		if (hll->sparse)
+			mm_free(hll->mm, hll->sparse);
+		hll->sparse = sparse;
+		hll->sparse_cap = cap;
+	}
+
+	/* merge backwards in place, the higher rank of an index comes last */
+	u32 *s = hll->sparse, i = hll->sparse_len, j = n, k = i + j, out;
+	while (j) {
+		if (i && s[i - 1] > tmp[j - 1])
+			s[--k] = s[--i];
+		else
+			s[--k] = tmp[--j];
+	}
+
+	for (i = 0, out = 0; i < hll->sparse_len + n; i++) {
+		if (out && (s[out - 1] >> 6) == (s[i] >> 6))
+			out--;
+		s[out++] = s[i];
+	}
+
+	hll->sparse_len = out;
+	hll->tmp_len = 0;
+
+	/* dense registers are smaller now */
+	if ((size_t)hll->sparse_len * sizeof(u32) > ((size_t)1 << hll->p))
+		hll_dense(hll);
+}
+
+void
+hll_add_sparse(struct hll *hll, u64 hash)
+{
+	hll->tmp[hll->tmp_len++] = hll_sparse_encode(hash);
+	if (hll->tmp_len == HLL_SPARSE_BUF)
+		hll_sparse_flush(hll);
+}
+
+/* decode sparse entry into the dense register of lower precision */
+static inline void
+hll_dense_put(u8 *regs, unsigned int p, u32 e)
+{
+	unsigned int shift = HLL_SPARSE_P - p;
+	u32 index = e >> 6, low = index & ((1U << shift) - 1);
+	u8 rank = low ? shift - (31 - __builtin_clz(low)) : shift + (e & 63);
+	index >>= shift;
+	if (regs[index] < rank)
+		regs[index] = rank;
+}
+
+static void
+hll_dense(struct hll *hll)
+{
+	size_t m = (size_t)1 << hll->p;
+	u8 *regs = mm_alloc(hll->mm, m);
+	memset(regs, 0, m);
+
+	for (u32 i = 0; i < hll->sparse_len; i++)
+		hll_dense_put(regs, hll->p, hll->sparse[i]);
+	for (u32 i = 0; i < hll->tmp_len; i++)
+		hll_dense_put(regs, hll->p, hll->tmp[i]);
+
+	if (hll->sparse)
+		mm_free(hll->mm, hll->sparse);
+	hll->sparse = NULL;
+	hll->sparse_len = hll->sparse_cap = hll->tmp_len = 0;
+	hll->regs = regs;
+}
+
+static void
+hll_regs_max(u8 *dst, const u8 *src, size_t m)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	for (; i + 32 <= m; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_max_epu8(a, b));
+	}
+#elif defined(__SSE2__)
+	for (; i + 16 <= m; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_max_epu8(a, b));
+	}
+#endif
+	for (; i < m; i++)
+		dst[i] = __max(dst[i], src[i]);
+}
+
+void
+hll_merge(struct hll *dst, struct hll *src)
+{
+	assert(dst->p == src->p);
+	if (src->regs) {
+		if (!dst->regs)
+			hll_dense(dst);
+		hll_regs_max(dst->regs, src->regs, (size_t)1 << dst->p);
+		return;
+	}
+
+	for (u32 i = 0; i < src->sparse_len + src->tmp_len; i++) {
+		u32 e = i < src->sparse_len ? src->sparse[i] :
+		                              src->tmp[i - src->sparse_len];
+		if (dst->regs) {
+			hll_dense_put(dst->regs, dst->p, e);
+			continue;
+		}
+		dst->tmp[dst->tmp_len++] = e;
+		if (dst->tmp_len == HLL_SPARSE_BUF)
+			hll_sparse_flush(dst);
+	}
+}
+
+static double
+hll_alpha(size_t m)
+{
+	switch (m) {
+	case 16: return 0.673;
+	case 32: return 0.697;
+	case 64: return 0.709;
+	default: return 0.7213 / (1.0 + 1.079 / m);
+	}
+}
+
+double
+hll_count(struct hll *hll)
+{
+	if (!hll->regs) {
+		/* linear counting with 2^25 sparse registers */
+		if (hll->tmp_len)
+			hll_sparse_flush(hll);
+		if (!hll->regs) {
+			double m = (double)(1U << HLL_SPARSE_P);
+			return m * log(m / (m - hll->sparse_len));
+		}
+	}
+
+	size_t m = (size_t)1 << hll->p, zeros = 0;
+	double sum = 0;
+	for (size_t i = 0; i < m; i++) {
+		sum += ldexp(1.0, -hll->regs[i]);
+		zeros += !hll->regs[i];
+	}
+
+	double estimate = hll_alpha(m) * m * m / sum;
+	if (estimate <= 2.5 * m && zeros)
+		estimate = m * log((double)m / zeros);
+	return estimate;
+}
@@ -0,0 +1,120 @@
+/*
+ * HyperLogLog cardinality estimator
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_HLL_H__
+#define __GENERIC_HASH_HLL_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * HyperLogLog
+ *
+ * Flajolet, Fusy, Gandouet, Meunier: HyperLogLog: the analysis of a 
+ * near-optimal cardinality estimation algorithm
+ *
+ * Heule, Nunkesser, Hall: HyperLogLog in Practice (HLL++), sparse 
+ * representation
+ *
+ * Counts distinct keys in fixed memory: 2^p one byte registers, standard 
+ * error is 1.04/sqrt(2^p). Keys are given by their 64-bit hash (hash_u64(x, 
+ * 64), hash_buffer(), ...). Small sets are kept in a sparse list of 
+ * (index, rank) pairs with 25 bit precision which switches to the dense 
+ * registers once it would be larger than them.
+ *
+ * Sketches with the same precision can be merged, the union of the dense
+ * registers is a byte-wise max done 16 or 32 registers at a time.
+ */
+
+#define HLL_P_MIN        4
+#define HLL_P_MAX        18
+#define HLL_SPARSE_P     25
+#define HLL_SPARSE_BUF   64
+
+struct hll {
+	struct mm *mm;
+	u8 *regs;             /* dense registers or NULL while sparse      */
+	u32 *sparse;          /* sorted (index << 6 | rank) entries        */
+	u32 sparse_len;
+	u32 sparse_cap;
+	u32 tmp_len;          /* unsorted entries waiting for merge        */
+	u32 tmp[HLL_SPARSE_BUF];
+	unsigned int p;
+};
+
+void
+hll_init(struct hll *hll, struct mm *mm, unsigned int p);
+
+void
+hll_fini(struct hll *hll);
+
+void
+hll_reset(struct hll *hll);
+
+/*
+ * hll_merge - add all keys of @src to @dst, precision must match 
+ */
+
+void
+hll_merge(struct hll *dst, struct hll *src);
+
+double
+hll_count(struct hll *hll);
+
+void
+hll_add_sparse(struct hll *hll, u64 hash);
+
+static inline void
+hll_add(struct hll *hll, u64 hash)
+{
+	if (unlikely(!hll->regs)) {
+		hll_add_sparse(hll, hash);
+		return;
+	}
+
+	unsigned int p = hll->p;
+	u64 index = hash >> (64 - p);
+	u8 rank = (u8)__builtin_clzll((hash << p) | (1ULL << (p - 1))) + 1;
+	if (hll->regs[index] < rank)
+		hll->regs[index] = rank;
+}
+
+/* memory used by the sketch */
+static inline size_t
+hll_size(const struct hll *hll)
+{
+	return hll->regs ? (size_t)1 << hll->p : hll->sparse_cap * sizeof(u32);
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * String interning
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <mem/pool.h>
+#include <bsd/hash/intern.h>
+#include <string.h>
+
+#define INTERN_MIN_BITS 8
+
+static inline unsigned int
+intern_bucket(struct intern *intern, u64 hash)
+{
+	return (unsigned int)(hash >> (64 - intern->bits));
+}
+
+static struct tailq *
+intern_table(struct intern *intern, unsigned int bits)
+{
+	size_t size = (size_t)1 << bits;
+	struct tailq *table = mm_pool_alloc(intern->pool, size * sizeof(*table));
+	for (size_t i = 0; i < size; i++)
+		table[i] = init_tailq;
+	return table;
+}
+
+void
+intern_init(struct intern *intern, struct mm_pool *pool)
+{
+	memset(intern, 0, sizeof(*intern));
+	intern->pool = pool;
+	intern->bits = INTERN_MIN_BITS;
+	intern->table = intern_table(intern, intern->bits);
+}
+
+/* load factor 1, the chains are walked by hash only */
+static void
+intern_grow(struct intern *intern)
+{
+	intern->bits++;
+	intern->table = intern_table(intern, intern->bits);
+	for (u32 i = 0; i < intern->count; i++) {
+		struct intern_entry *e = intern->ids[i];
+		tailq_add(&intern->table[intern_bucket(intern, e->hash)], &e->node);
+	}
+}
+
+static const char *
+intern_lookup(struct intern *intern, const char *str, size_t len, u64 hash)
+{
+	struct qnode *it;
+	tailq_walk(&intern->table[intern_bucket(intern, hash)], it) {
+		struct intern_entry *e = __container_of(it, struct intern_entry, node);
+		if (e->hash == hash && e->len == len && !memcmp(e->str, str, len))
+			return e->str;
+	}
+	return NULL;
+}
+
+static const char *
+intern_add(struct intern *intern, const char *str, size_t len, u64 hash)
+{
+	const char *s = intern_lookup(intern, str, len, hash);
+	if (s)
+		return s;
+
+	if (intern->count == intern->capacity) {
+		u32 capacity = __max(intern->capacity * 2, 64);
+		struct intern_entry **ids = 
+			mm_pool_alloc(intern->pool, capacity * sizeof(*ids));
+		if (intern->count)
+			memcpy(ids, intern->ids, intern->count * sizeof(*ids));
+		intern->ids = ids;
+		intern->capacity = capacity;
+	}
+
+	/* mm_pool_alloc() does not align, keep the next entry aligned */
+	struct intern_entry *e = 
+		mm_pool_alloc(intern->pool, align_addr(sizeof(*e) + len + 1));
+	memcpy(e->str, str, len);
+	e->str[len] = 0;
+	e->hash = hash;
+	e->len = (u32)len;
+	e->id = intern->count;
+
+	intern->ids[intern->count++] = e;
+	intern->bytes += len;
+	tailq_add(&intern->table[intern_bucket(intern, hash)], &e->node);
+
+	if (intern->count >> intern->bits)
+		intern_grow(intern);
+	return e->str;
+}
+
+const char *
+intern_mem(struct intern *intern, const char *str, size_t len)
+{
+	return intern_add(intern, str, len, hash_buffer((const u8 *)str, len));
+}
+
+const char *
+intern_str(struct intern *intern, const char *str)
+{
+	size_t len;
+	u64 hash = hash_string_len(str, &len);
+	return intern_add(intern, str, len, hash);
+}
+
+const char *
+intern_find(struct intern *intern, const char *str, size_t len)
+{
+	return intern_lookup(intern, str, len, hash_buffer((const u8 *)str, len));
+}
+
+void
+intern_sync_init(struct intern_sync *sync, size_t blocksize)
+{
+	for (unsigned int i = 0; i < INTERN_SHARDS; i++) {
+		pthread_mutex_init(&sync->shard[i].lock, NULL);
+		intern_init(&sync->shard[i].intern, mm_pool_create(blocksize, 0));
+	}
+}
+
+void
+intern_sync_fini(struct intern_sync *sync)
+{
+	for (unsigned int i = 0; i < INTERN_SHARDS; i++) {
+		pthread_mutex_destroy(&sync->shard[i].lock);
+		mm_pool_destroy(sync->shard[i].intern.pool);
+	}
+}
+
+/* the shard comes from the low bits, the buckets use the high bits */
+static const char *
+intern_sync_add(struct intern_sync *sync, const char *str, size_t len, 
+                u64 hash)
+{
+	unsigned int i = hash % INTERN_SHARDS;
+	pthread_mutex_lock(&sync->shard[i].lock);
+	const char *s = intern_add(&sync->shard[i].intern, str, len, hash);
+	pthread_mutex_unlock(&sync->shard[i].lock);
+	return s;
+}
+
+const char *
+intern_sync_mem(struct intern_sync *sync, const char *str, size_t len)
+{
+	return intern_sync_add(sync, str, len, hash_buffer((const u8 *)str, len));
+}
+
+const char *
+intern_sync_str(struct intern_sync *sync, const char *str)
+{
+	size_t len;
+	u64 hash = hash_string_len(str, &len);
+	return intern_sync_add(sync, str, len, hash);
+}
+
+const char *
+intern_sync_get(struct intern_sync *sync, u32 id)
+{
+	unsigned int i = id % INTERN_SHARDS;
+	pthread_mutex_lock(&sync->shard[i].lock);
+	const char *s = intern_get(&sync->shard[i].intern, id / INTERN_SHARDS);
+	pthread_mutex_unlock(&sync->shard[i].lock);
+	return s;
+}
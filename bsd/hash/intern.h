@@ -0,0 +1,175 @@
+/*
+ * String interning
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_INTERN_H__
+#define __GENERIC_HASH_INTERN_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/tailq.h>
+#include <bsd/hash/fn.h>
+#include <pthread.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory pool */
+struct mm_pool;
+
+/*
+ * String interning
+ *
+ * Every distinct string is stored once in a memory pool and interning the 
+ * same bytes again returns the same pointer, so interned strings compare 
+ * with == and carry a dense 32-bit id. The lookup hashes with 
+ * hash_string_len() (one pass for length and hash) or hash_buffer().
+ *
+ * The strings, the buckets and the id table all live in the pool and are 
+ * released together with it; outgrown bucket and id arrays stay in the pool,
+ * which costs at most as much as the final arrays.
+ *
+ * struct intern_sync is a thread-safe variant sharded by hash, every shard 
+ * has its own mutex and pool. Its ids are shard + INTERN_SHARDS * local id.
+ */
+
+#define INTERN_SHARDS 16
+
+struct intern_entry {
+	struct qnode node;
+	u64 hash;
+	u32 id;
+	u32 len;
+	char str[];
+};
+
+struct intern {
+	struct mm_pool *pool;
+	struct tailq *table;
+	struct intern_entry **ids;
+	unsigned int bits;
+	u32 count;
+	u32 capacity;         /* size of the id table                      */
+	size_t bytes;         /* string bytes stored                       */
+};
+
+struct intern_sync {
+	struct {
+		pthread_mutex_t lock;
+		struct intern intern;
+	} _align(CPU_CACHE_LINE) shard[INTERN_SHARDS];
+};
+
+/*
+ * intern_init - create interning table
+ *
+ * @intern:     the table
+ * @pool:       memory pool for strings and index
+ */
+
+void
+intern_init(struct intern *intern, struct mm_pool *pool);
+
+/**
+ * intern_mem - intern string of given length
+ *
+ * @intern:     the table
+ * @str:        the string, does not need to be NUL-terminated
+ * @len:        string length
+ *
+ * Returns stable NUL-terminated copy of the string.
+ */
+
+const char *
+intern_mem(struct intern *intern, const char *str, size_t len);
+
+/* intern_mem() for NUL-terminated string */
+const char *
+intern_str(struct intern *intern, const char *str);
+
+/* returns interned string or NULL, never adds */
+const char *
+intern_find(struct intern *intern, const char *str, size_t len);
+
+static inline struct intern_entry *
+intern_entry(const char *str)
+{
+	return __container_of(str, struct intern_entry, str);
+}
+
+/* id of interned string */
+static inline u32
+intern_id(const char *str)
+{
+	return intern_entry(str)->id;
+}
+
+/* length of interned string */
+static inline size_t
+intern_len(const char *str)
+{
+	return intern_entry(str)->len;
+}
+
+/* interned string by id */
+static inline const char *
+intern_get(struct intern *intern, u32 id)
+{
+	return id < intern->count ? intern->ids[id]->str: NULL;
+}
+
+static inline u32
+intern_count(struct intern *intern)
+{
+	return intern->count;
+}
+
+/* every shard creates its own pool of blocksize */
+void
+intern_sync_init(struct intern_sync *sync, size_t blocksize);
+
+void
+intern_sync_fini(struct intern_sync *sync);
+
+const char *
+intern_sync_mem(struct intern_sync *sync, const char *str, size_t len);
+
+const char *
+intern_sync_str(struct intern_sync *sync, const char *str);
+
+const char *
+intern_sync_get(struct intern_sync *sync, u32 id);
+
+/* id of string interned by intern_sync */
+static inline u32
+intern_sync_id(const char *str)
+{
+	struct intern_entry *e = intern_entry(str);
+	return (u32)(e->hash % INTERN_SHARDS) + INTERN_SHARDS * e->id;
+}
+
+__END_DECLS
+
+#endif
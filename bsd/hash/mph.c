@@ -0,0 +1,241 @@
+/*
+ * Minimal perfect hash for large static key sets
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/mph.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct mph_level {
+	u64 *seen;
+	u64 *collide;
+	u64 offset;           /* bit offset of the level                   */
+	u64 size;             /* bits in the level                         */
+	unsigned int level;
+};
+
+struct mph_task {
+	pthread_t thread;
+	struct mph_level *level;
+	u64 *keys;
+	u64 count;
+	u64 kept;
+};
+
+/* pass 1: set seen bits, record bits hit more than once */
+static void *
+mph_mark(void *arg)
+{
+	struct mph_task *task = arg;
+	struct mph_level *l = task->level;
+	for (u64 k = 0; k < task->count; k++) {
+		u64 bit = mph_range(mph_level_hash(task->keys[k], l->level), l->size);
+		u64 mask = 1ULL << (bit & 63);
+		u64 old = __atomic_fetch_or(&l->seen[bit >> 6], mask, __ATOMIC_RELAXED);
+		if (old & mask)
+			__atomic_fetch_or(&l->collide[bit >> 6], mask, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+/* pass 2: keep colliding keys for the next level in front of the chunk */
+static void *
+mph_filter(void *arg)
+{
+	struct mph_task *task = arg;
+	struct mph_level *l = task->level;
+	u64 kept = 0;
+	for (u64 k = 0; k < task->count; k++) {
+		u64 bit = mph_range(mph_level_hash(task->keys[k], l->level), l->size);
+		if (l->collide[bit >> 6] & (1ULL << (bit & 63)))
+			task->keys[kept++] = task->keys[k];
+	}
+	task->kept = kept;
+	return NULL;
+}
+
+static void
+mph_run(struct mph_task *task, unsigned int threads, void *(*fn)(void *))
+{
+	if (threads == 1) {
+		fn(task);
+		return;
+	}
+	for (unsigned int i = 0; i < threads; i++)
+		if (pthread_create(&task[i].thread, NULL, fn, &task[i]))
+			fn(&task[i]), task[i].thread = 0;
+	for (unsigned int i = 0; i < threads; i++)
+		if (task[i].thread)
+			pthread_join(task[i].thread, NULL);
+}
+
+static int
+mph_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return (x > y) - (x < y);
+}
+
+static void
+mph_attach(struct mph *mph, const struct mph_hdr *hdr)
+{
+	mph->hdr = hdr;
+	mph->bits = (const u64 *)(hdr + 1);
+	mph->rank = mph->bits + hdr->words;
+	mph->fallback = mph->rank + hdr->words / 8 + 1;
+}
+
+void
+mph_build(struct mph *mph, struct mm *mm, const u64 *hash, u64 count, 
+          double gamma, unsigned int threads)
+{
+	struct mph_task task[MPH_MAX_THREADS];
+	u64 *level_bits[MPH_MAX_LEVELS];
+	struct mph_hdr hdr = { .magic = MPH_MAGIC, .count = count };
+	u64 left = count;
+
+	memset(mph, 0, sizeof(*mph));
+	mph->mm = mm;
+	gamma = __max(gamma, 1.0);
+	threads = __min(__max(threads, 1), MPH_MAX_THREADS);
+
+	u64 *keys = mm_alloc(mm, __max(count, 1) * sizeof(u64));
+	memcpy(keys, hash, count * sizeof(u64));
+
+	for (; left && hdr.levels < MPH_MAX_LEVELS; hdr.levels++) {
+		struct mph_level l = { .level = hdr.levels };
+		l.size = (((u64)(gamma * left) + 63) & ~63ULL);
+		l.offset = hdr.offset[hdr.levels];
+		l.seen = mm_zalloc(mm, l.size / 8);
+		l.collide = mm_zalloc(mm, l.size / 8);
+
+		unsigned int n = left < threads * 4096ULL ? 1: threads;
+		for (unsigned int i = 0; i < n; i++) {
+			u64 from = left * i / n, to = left * (i + 1) / n;
+			task[i] = (struct mph_task) { 
+				.level = &l, .keys = keys + from, .count = to - from 
+			};
+		}
+
+		mph_run(task, n, mph_mark);
+		mph_run(task, n, mph_filter);
+
+		u64 kept = 0;
+		for (unsigned int i = 0; i < n; i++) {
+			memmove(keys + kept, task[i].keys, task[i].kept * sizeof(u64));
+			kept += task[i].kept;
+		}
+
+		for (u64 i = 0; i < l.size / 64; i++)
+			l.seen[i] &= ~l.collide[i];
+		mm_free(mm, l.collide);
+
+		level_bits[hdr.levels] = l.seen;
+		hdr.offset[hdr.levels + 1] = l.offset + l.size;
+		left = kept;
+	}
+
+	hdr.words = hdr.offset[hdr.levels] / 64;
+	hdr.fallback = left;
+	hdr.ranked = count - left;
+	hdr.size = sizeof(hdr) + 
+	           (hdr.words + hdr.words / 8 + 1 + hdr.fallback) * sizeof(u64);
+
+	mph->addr = mm_alloc(mm, hdr.size);
+	memcpy(mph->addr, &hdr, sizeof(hdr));
+	mph_attach(mph, mph->addr);
+
+	u64 *bits = (u64 *)mph->bits, *rank = (u64 *)mph->rank;
+	for (unsigned int i = 0; i < hdr.levels; i++) {
+		u64 words = (hdr.offset[i + 1] - hdr.offset[i]) / 64;
+		memcpy(bits + hdr.offset[i] / 64, level_bits[i], words * sizeof(u64));
+		mm_free(mm, level_bits[i]);
+	}
+
+	u64 total = 0;
+	for (u64 i = 0; i < hdr.words; i++) {
+		if (!(i & 7))
+			rank[i / 8] = total;
+		total += __builtin_popcountll(bits[i]);
+	}
+	if (!(hdr.words & 7))
+		rank[hdr.words / 8] = total;
+
+	u64 *fallback = (u64 *)mph->fallback;
+	memcpy(fallback, keys, left * sizeof(u64));
+	qsort(fallback, left, sizeof(u64), mph_cmp);
+	mm_free(mm, keys);
+}
+
+int
+mph_load(struct mph *mph, const void *addr, size_t size)
+{
+	const struct mph_hdr *hdr = addr;
+	memset(mph, 0, sizeof(*mph));
+
+	if (size < sizeof(*hdr) || hdr->magic != MPH_MAGIC || hdr->size > size)
+		return -1;
+	if (hdr->levels > MPH_MAX_LEVELS || hdr->ranked + hdr->fallback != hdr->count)
+		return -1;
+	if (hdr->offset[hdr->levels] != hdr->words * 64)
+		return -1;
+	if (hdr->size != sizeof(*hdr) + (hdr->words + hdr->words / 8 + 1 + 
+	    hdr->fallback) * sizeof(u64))
+		return -1;
+
+	mph_attach(mph, hdr);
+	return 0;
+}
+
+void
+mph_fini(struct mph *mph)
+{
+	if (mph->addr)
+		mm_free(mph->mm, mph->addr);
+	memset(mph, 0, sizeof(*mph));
+}
+
+u64
+mph_lookup_slow(const struct mph *mph, u64 hash)
+{
+	const u64 *fallback = mph->fallback;
+	u64 lo = 0, hi = mph->hdr->fallback;
+	while (lo < hi) {
+		u64 mid = lo + (hi - lo) / 2;
+		if (fallback[mid] < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == mph->hdr->fallback && lo)
+		lo--;
+	return mph->hdr->ranked + lo;
+}
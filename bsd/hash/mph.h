@@ -0,0 +1,180 @@
+/*
+ * Minimal perfect hash for large static key sets
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_MPH_H__
+#define __GENERIC_HASH_MPH_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Minimal perfect hash
+ *
+ * Limasset, Rizk, Chikhi, Peterlongo: Fast and scalable minimal perfect 
+ * hashing for massive key sets (BBHash)
+ *
+ * Maps N distinct 64-bit key hashes onto [0, N) without storing the keys. 
+ * Level l is a bitmap of gamma * (keys left) bits, a key sets the bit it 
+ * hashes to and keeps it only when no other key hit the same bit. Colliding 
+ * keys move to the next level. The value of a key is the rank of its bit over
+ * all levels, keys left after MPH_MAX_LEVELS are kept in a small sorted 
+ * fallback array. gamma 1.0 needs about 3.1 bits per key, 2.0 about 3.7 bits 
+ * per key with fewer levels visited per lookup.
+ *
+ * The structure is one contiguous block: header, level bitmaps, rank table 
+ * (popcount before every 512 bits) and fallback. mph_data() returns it ready 
+ * to be written to a file and mph_load() uses a mapped file in place.
+ *
+ * Looking up a hash which was not in the set returns an arbitrary value, the 
+ * caller verifies the key stored at that index when needed.
+ */
+
+#define MPH_MAGIC       0x3148504d    /* "MPH1" */
+#define MPH_MAX_LEVELS  32
+#define MPH_MAX_THREADS 64
+
+struct mph_hdr {
+	u32 magic;
+	u32 levels;
+	u64 count;            /* number of keys                            */
+	u64 words;            /* 64-bit words of the level bitmaps         */
+	u64 ranked;           /* keys placed by the levels                 */
+	u64 fallback;         /* keys in the fallback array                */
+	u64 size;             /* size of the whole block in bytes          */
+	u64 offset[MPH_MAX_LEVELS + 1]; /* first bit of every level        */
+};
+
+struct mph {
+	struct mm *mm;
+	void *addr;           /* allocated by mph_build() or NULL          */
+	const struct mph_hdr *hdr;
+	const u64 *bits;
+	const u64 *rank;
+	const u64 *fallback;
+};
+
+/*
+ * mph_build - build the function
+ *
+ * @mph:        the function
+ * @mm:         memory context
+ * @hash:       distinct key hashes (hash_buffer(), hash_string(), ...)
+ * @count:      number of keys
+ * @gamma:      bits per key of level bitmaps, >= 1.0
+ * @threads:    number of build threads
+ */
+
+void
+mph_build(struct mph *mph, struct mm *mm, const u64 *hash, u64 count, 
+          double gamma, unsigned int threads);
+
+/*
+ * mph_load - use serialized function in place
+ *
+ * @mph:        the function
+ * @addr:       data from mph_data(), 8-byte aligned (mmap)
+ * @size:       size of the data
+ *
+ * Returns 0 or -1 when the data is not valid.
+ */
+
+int
+mph_load(struct mph *mph, const void *addr, size_t size);
+
+void
+mph_fini(struct mph *mph);
+
+/* serialized form */
+static inline const void *
+mph_data(const struct mph *mph, size_t *size)
+{
+	*size = (size_t)mph->hdr->size;
+	return mph->hdr;
+}
+
+/* fallback lookup */
+u64
+mph_lookup_slow(const struct mph *mph, u64 hash);
+
+static inline u64
+mph_level_hash(u64 hash, unsigned int level)
+{
+	u64 x = hash + (level + 1) * 0x9e3779b97f4a7c15ULL;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+/* maps x onto [0, size) without division */
+static inline u64
+mph_range(u64 x, u64 size)
+{
+	return (u64)(((unsigned __int128)x * size) >> 64);
+}
+
+static inline u64
+mph_rank(const struct mph *mph, u64 bit)
+{
+	u64 word = bit >> 6, i = (bit >> 9) << 3;
+	u64 rank = mph->rank[bit >> 9];
+	for (; i < word; i++)
+		rank += __builtin_popcountll(mph->bits[i]);
+	return rank + __builtin_popcountll(mph->bits[word] & 
+	                                   ((1ULL << (bit & 63)) - 1));
+}
+
+static inline u64
+mph_lookup(const struct mph *mph, u64 hash)
+{
+	const struct mph_hdr *hdr = mph->hdr;
+	for (unsigned int l = 0; l < hdr->levels; l++) {
+		u64 size = hdr->offset[l + 1] - hdr->offset[l];
+		u64 bit = hdr->offset[l] + mph_range(mph_level_hash(hash, l), size);
+		if (mph->bits[bit >> 6] & (1ULL << (bit & 63)))
+			return mph_rank(mph, bit);
+	}
+	return mph_lookup_slow(mph, hash);
+}
+
+/* size of the function in bytes */
+static inline size_t
+mph_size(const struct mph *mph)
+{
+	return (size_t)mph->hdr->size;
+}
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ * Compile-time perfect hashing for static string sets (C++14)
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_PERFECT_H__
+#define __GENERIC_HASH_PERFECT_H__
+
+#ifdef __cplusplus
+
+/*
+ * Compile-time perfect hashing
+ *
+ * Builds a collision free table over a fixed list of strings while compiling,
+ * so dispatching on protocol keywords costs one hash, one displacement load, 
+ * one slot load and one compare, with no construction at runtime.
+ *
+ *   static constexpr const char *methods[] = { "GET", "PUT", "POST", ... };
+ *   static constexpr auto m = perfect_hash_make(methods);
+ *
+ *   int id = m.find(str, len);    index into methods[] or -1
+ *
+ * The construction is hash-and-displace (Belazzougui, Botelho, Dietzfelbinger:
+ * Hash, displace, and compress). Keys are grouped into buckets of ~4 by the 
+ * top bits of their hash, buckets are placed largest first and every bucket 
+ * gets the smallest displacement d for which all of its keys land in free 
+ * slots of a power of two table, the top bits of (hash ^ d * p1) * p2.
+ *
+ * perfect_hash_xxh64() is a constexpr port of XXH64 with seed 0 and returns 
+ * the same values as hash_buffer() from <bsd/hash/fn.h>, so the hash can be 
+ * computed by C code as well. This header deliberately avoids 
+ * <sys/compiler.h>, its inline redefinition breaks the C++ library headers.
+ *
+ * Duplicate keys make the construction fail at compile time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PERFECT_HASH_MAX_DISP 0xffff
+
+static constexpr uint64_t PERFECT_PRIME64_1 = 11400714785074694791ULL;
+static constexpr uint64_t PERFECT_PRIME64_2 = 14029467366897019727ULL;
+static constexpr uint64_t PERFECT_PRIME64_3 =  1609587929392839161ULL;
+static constexpr uint64_t PERFECT_PRIME64_4 =  9650029242287828579ULL;
+static constexpr uint64_t PERFECT_PRIME64_5 =  2870177450012600261ULL;
+
+static constexpr inline uint64_t
+perfect_hash_rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static constexpr inline uint64_t
+perfect_hash_read64(const char *p)
+{
+	return  (uint64_t)(uint8_t)p[0]        | (uint64_t)(uint8_t)p[1] << 8  |
+	        (uint64_t)(uint8_t)p[2] << 16  | (uint64_t)(uint8_t)p[3] << 24 |
+	        (uint64_t)(uint8_t)p[4] << 32  | (uint64_t)(uint8_t)p[5] << 40 |
+	        (uint64_t)(uint8_t)p[6] << 48  | (uint64_t)(uint8_t)p[7] << 56;
+}
+
+static constexpr inline uint64_t
+perfect_hash_read32(const char *p)
+{
+	return  (uint64_t)(uint8_t)p[0]        | (uint64_t)(uint8_t)p[1] << 8  |
+	        (uint64_t)(uint8_t)p[2] << 16  | (uint64_t)(uint8_t)p[3] << 24;
+}
+
+static constexpr inline uint64_t
+perfect_hash_round(uint64_t acc, uint64_t input)
+{
+	return perfect_hash_rotl(acc + input * PERFECT_PRIME64_2, 31) * 
+	       PERFECT_PRIME64_1;
+}
+
+static constexpr inline uint64_t
+perfect_hash_merge(uint64_t acc, uint64_t val)
+{
+	return (acc ^ perfect_hash_round(0, val)) * PERFECT_PRIME64_1 + 
+	       PERFECT_PRIME64_4;
+}
+
+/**
+ * perfect_hash_xxh64 - XXH64 with seed 0, usable in constant expressions
+ *
+ * @p:          the buffer
+ * @len:        buffer length
+ */
+
+static constexpr inline uint64_t
+perfect_hash_xxh64(const char *p, size_t len)
+{
+	const char *end = p + len;
+	uint64_t h = 0;
+
+	if (len >= 32) {
+		uint64_t v1 = PERFECT_PRIME64_1 + PERFECT_PRIME64_2;
+		uint64_t v2 = PERFECT_PRIME64_2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0 - PERFECT_PRIME64_1;
+		do {
+			v1 = perfect_hash_round(v1, perfect_hash_read64(p));
+			v2 = perfect_hash_round(v2, perfect_hash_read64(p + 8));
+			v3 = perfect_hash_round(v3, perfect_hash_read64(p + 16));
+			v4 = perfect_hash_round(v4, perfect_hash_read64(p + 24));
+			p += 32;
+		} while (p + 32 <= end);
+
+		h = perfect_hash_rotl(v1, 1)  + perfect_hash_rotl(v2, 7) +
+		    perfect_hash_rotl(v3, 12) + perfect_hash_rotl(v4, 18);
+		h = perfect_hash_merge(h, v1);
+		h = perfect_hash_merge(h, v2);
+		h = perfect_hash_merge(h, v3);
+		h = perfect_hash_merge(h, v4);
+	} else {
+		h = PERFECT_PRIME64_5;
+	}
+
+	h += (uint64_t)len;
+
+	for (; p + 8 <= end; p += 8) {
+		h ^= perfect_hash_round(0, perfect_hash_read64(p));
+		h  = perfect_hash_rotl(h, 27) * PERFECT_PRIME64_1 + 
+		     PERFECT_PRIME64_4;
+	}
+
+	if (p + 4 <= end) {
+		h ^= perfect_hash_read32(p) * PERFECT_PRIME64_1;
+		h  = perfect_hash_rotl(h, 23) * PERFECT_PRIME64_2 + 
+		     PERFECT_PRIME64_3;
+		p += 4;
+	}
+
+	for (; p < end; p++) {
+		h ^= (uint64_t)(uint8_t)*p * PERFECT_PRIME64_5;
+		h  = perfect_hash_rotl(h, 11) * PERFECT_PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= PERFECT_PRIME64_2;
+	h ^= h >> 29;
+	h *= PERFECT_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static constexpr inline size_t
+perfect_hash_strlen(const char *str)
+{
+	size_t len = 0;
+	while (str[len])
+		len++;
+	return len;
+}
+
+static constexpr inline unsigned int
+perfect_hash_bits(size_t size)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < size)
+		bits++;
+	return bits;
+}
+
+/*
+ * Not constexpr on purpose: reaching it while the table is built at compile 
+ * time is a hard error naming this function, at runtime it traps.
+ */
+
+static inline void
+perfect_hash_duplicate_keys(void)
+{
+	__builtin_trap();
+}
+
+template <size_t N>
+struct perfect_hash {
+	/* load factor at most 0.8, about 4 keys per bucket */
+	static constexpr unsigned int bits = perfect_hash_bits(N + N / 4 + 1);
+	static constexpr unsigned int bucket_bits = 
+		perfect_hash_bits((N + 3) / 4) ? perfect_hash_bits((N + 3) / 4): 1;
+	static constexpr size_t size = (size_t)1 << bits;
+	static constexpr size_t buckets = (size_t)1 << bucket_bits;
+	static constexpr size_t mask = size - 1;
+
+	uint16_t disp[buckets];
+	int32_t slot[size];
+	const char *key[N];
+	size_t len[N];
+
+	static constexpr inline size_t
+	bucket(uint64_t hash)
+	{
+		return (size_t)(hash >> (64 - bucket_bits));
+	}
+
+	/* remix all 64 bits, keys equal in the low bits still separate */
+	static constexpr inline size_t
+	index(uint64_t hash, uint64_t d)
+	{
+		uint64_t x = (hash ^ (d * PERFECT_PRIME64_1)) * PERFECT_PRIME64_2;
+		return (size_t)(x >> (64 - bits));
+	}
+
+	constexpr 
+	perfect_hash(const char *const (&keys)[N]) 
+	: disp{}, slot{}, key{}, len{}
+	{
+		uint64_t hash[N] = {};
+		size_t count[buckets + 1] = {};
+		size_t member[N] = {};
+		size_t max = 0;
+
+		for (size_t i = 0; i < N; i++) {
+			key[i] = keys[i];
+			len[i] = perfect_hash_strlen(keys[i]);
+			hash[i] = perfect_hash_xxh64(keys[i], len[i]);
+			count[bucket(hash[i]) + 1]++;
+		}
+
+		for (size_t b = 0; b < buckets; b++)
+			max = count[b + 1] > max ? count[b + 1]: max;
+		for (size_t b = 0; b < buckets; b++)
+			count[b + 1] += count[b];
+
+		/* count[b] .. count[b + 1] are the members of bucket b */
+		size_t fill[buckets] = {};
+		for (size_t i = 0; i < N; i++) {
+			size_t b = bucket(hash[i]);
+			member[count[b] + fill[b]++] = i;
+		}
+
+		for (size_t i = 0; i < size; i++)
+			slot[i] = -1;
+
+		for (size_t n = max; n > 0; n--)
+		for (size_t b = 0; b < buckets; b++) {
+			if (count[b + 1] - count[b] != n)
+				continue;
+			uint64_t d = 0;
+			for (;; d++) {
+				if (d > PERFECT_HASH_MAX_DISP)
+					perfect_hash_duplicate_keys();
+				size_t j = count[b];
+				for (; j < count[b + 1]; j++) {
+					size_t i = index(hash[member[j]], d);
+					if (slot[i] != -1)
+						break;
+					slot[i] = (int32_t)member[j];
+				}
+				if (j == count[b + 1])
+					break;
+				for (size_t k = count[b]; k < j; k++)
+					slot[index(hash[member[k]], d)] = -1;
+			}
+			disp[b] = (uint16_t)d;
+		}
+	}
+
+	/**
+	 * find - lookup string
+	 *
+	 * @str:        the string, not necessarily NUL-terminated
+	 * @size:       string length
+	 *
+	 * Returns index of the key in the list given to the constructor or -1.
+	 */
+
+	inline int
+	find(const char *str, size_t size) const
+	{
+		uint64_t hash = perfect_hash_xxh64(str, size);
+		int32_t i = slot[index(hash, disp[bucket(hash)])];
+		if (i < 0 || len[i] != size || memcmp(key[i], str, size))
+			return -1;
+		return i;
+	}
+
+	inline int
+	find(const char *str) const
+	{
+		return find(str, strlen(str));
+	}
+};
+
+template <size_t N>
+constexpr inline perfect_hash<N>
+perfect_hash_make(const char *const (&keys)[N])
+{
+	return perfect_hash<N>(keys);
+}
+
+#endif/* __cplusplus */
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Hash table instrumentation
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/hash/stat.h>
+#include <string.h>
+
+void
+hash_stat_table(struct hash_stat *stat, const struct tailq *table, 
+                unsigned int bits, unsigned int step)
+{
+	u64 size = 1ULL << bits, sum2 = 0;
+	memset(stat, 0, sizeof(*stat));
+	step = __max(step, 1);
+
+	/* runs of HASH_STAT_RUN buckets, strided sampling aliases with keys */
+	for (u64 i = 0; i < size; i++) {
+		if (step > 1 && i % HASH_STAT_RUN == 0 && i % (HASH_STAT_RUN * step))
+			i += HASH_STAT_RUN * (step - 1);
+		if (i >= size)
+			break;
+
+		u64 len = 0;
+		for (struct qnode *it = table[i].head; it; it = it->next)
+			len++;
+
+		stat->buckets++;
+		stat->items += len;
+		stat->empty += !len;
+		stat->max = __max(stat->max, len);
+		stat->hist[__min(len, HASH_STAT_HIST - 1)]++;
+		sum2 += len * len;
+	}
+
+	if (!stat->buckets)
+		return;
+
+	double m = (double)stat->buckets, n = (double)stat->items;
+	stat->load = n / m;
+	stat->probes_miss = stat->load;
+	if (stat->buckets > stat->empty)
+		stat->mean = n / (m - stat->empty);
+	if (stat->items)
+		stat->probes_hit = ((double)sum2 + n) / (2 * n);
+
+	/* sum((len - load)^2 / load) = sum(len^2) / load - n */
+	if (stat->items && stat->buckets > 1)
+		stat->chi2 = ((double)sum2 / stat->load - n) / (m - 1);
+}
@@ -0,0 +1,109 @@
+/*
+ * Hash table instrumentation
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_HASH_STAT_H__
+#define __GENERIC_HASH_STAT_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/tailq.h>
+#include <bsd/hash/table.h>
+
+__BEGIN_DECLS
+
+/*
+ * Hash table instrumentation
+ *
+ * hash_stat() walks the buckets of a live DECLARE_HASHTABLE table and reports
+ * how well the hash function spreads the real keys. With step > 1 only every
+ * step-th run of HASH_STAT_RUN consecutive buckets is visited, which keeps 
+ * periodic runs on large tables cheap. Runs rather than single buckets make 
+ * regular key patterns in the low bucket bits visible to the sample.
+ *
+ *   chi2        chi-square statistic divided by its degrees of freedom, 
+ *               about 1.0 for a uniform hash, well above 1.0 means the hash 
+ *               function (or the bucket bits taken from it) clusters keys
+ *   probes_hit  expected nodes compared by a successful lookup
+ *   probes_miss expected nodes compared by an unsuccessful lookup
+ *
+ * hash_for_each_probe() is hash_for_each() which also counts lookups and 
+ * visited nodes in a struct hash_probe, giving the measured probe count of
+ * the real lookup mix.
+ */
+
+#define HASH_STAT_HIST 16
+#define HASH_STAT_RUN  64
+
+struct hash_stat {
+	u64 buckets;          /* buckets visited                           */
+	u64 items;            /* nodes in visited buckets                  */
+	u64 empty;            /* empty buckets                             */
+	u64 max;              /* longest chain                             */
+	u64 hist[HASH_STAT_HIST]; /* buckets by chain length, last is >=   */
+	double load;          /* items per bucket                          */
+	double mean;          /* mean length of non-empty chains           */
+	double probes_hit;
+	double probes_miss;
+	double chi2;
+};
+
+struct hash_probe {
+	u64 lookups;
+	u64 probes;
+};
+
+/**
+ * hash_stat_table - collect bucket statistics
+ *
+ * @stat:       the result
+ * @table:      bucket array
+ * @bits:       log2 of the number of buckets
+ * @step:       visit every step-th run of buckets, 1 for all
+ */
+
+void
+hash_stat_table(struct hash_stat *stat, const struct tailq *table, 
+                unsigned int bits, unsigned int step);
+
+#define hash_stat(table, stat, step) \
+	hash_stat_table(stat, table, hash_bits(table), step)
+
+static inline double
+hash_probe_avg(const struct hash_probe *probe)
+{
+	return probe->lookups ? (double)probe->probes / probe->lookups : 0;
+}
+
+#define hash_for_each_probe(table, hash, it, type, member, probe) \
+	for (type *(it) = ((probe)->lookups++, \
+	     container_of_safe((table[hash]).head, type, member)); \
+	     (it) && ((probe)->probes++, 1); \
+	     (it) = container_of_safe(it->member.next, type, member))
+
+__END_DECLS
+
+#endif
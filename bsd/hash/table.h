@@ -35,6 +35,17 @@
 
 __BEGIN_DECLS
 
+/*
+ * Buckets are struct tailq, which is an hlist: a single head pointer and
+ * nodes linked with next/pprev, so a table of 2^bits buckets costs
+ * 8 << bits bytes on 64-bit and a node can be removed without its bucket.
+ */
+
+#ifndef __cplusplus
+_Static_assert(sizeof(struct tailq) == sizeof(void *),
+               "hash bucket must be a single pointer");
+#endif
+
 #define DECLARE_HASHTABLE(name, bits) \
 	struct tailq name[1 << (bits)]
 #define DEFINE_HASHTABLE(name, bits) DECLARE_HASHTABLE(name, bits) = { \
@@ -68,6 +79,39 @@ __BEGIN_DECLS
 #define hash_for_each_delsafe(table, hash, it, type, member) \
 	tailq_for_each_delsafe((table[hash]), it, type, member)
 
+#define hash_prefetch(table, hash) __builtin_prefetch(&(table[hash]))
+
+/**
+ * hash_lookup_many - find a batch of keys
+ *
+ * @table:      the hash table
+ * @hashes:     bucket index of each key
+ * @count:      number of keys
+ * @keys:       the keys
+ * @result:     found items or NULL
+ * @type:       the structure type
+ * @member:     the name of the node within the struct.
+ * @eq:         eq(item, key) returns non-zero when item matches the key
+ *
+ * All bucket heads are prefetched first, then all first nodes, and only then
+ * are the chains compared, so the cache misses of the whole batch overlap 
+ * instead of being paid one key at a time.
+ */
+
+#define hash_lookup_many(table, hashes, count, keys, result, type, member, eq) \
+({ \
+	for (unsigned __i = 0; __i < (count); __i++) \
+		hash_prefetch(table, (hashes)[__i]); \
+	for (unsigned __i = 0; __i < (count); __i++) \
+		if ((table)[(hashes)[__i]].head) \
+			__builtin_prefetch((table)[(hashes)[__i]].head); \
+	for (unsigned __i = 0; __i < (count); __i++) { \
+		(result)[__i] = NULL; \
+		hash_for_each(table, (hashes)[__i], __it, type, member) \
+			if (eq(__it, (keys)[__i])) { (result)[__i] = __it; break; } \
+	} \
+})
+
 __END_DECLS
 
 #endif
@@ -168,6 +168,7 @@ static inline void
 list_enable_prev(struct list *list, struct node *head)
 {
 	struct node *node;
+	head->prev = &list->head;
 	for (node = head; node->next; ) {
 		node->next->prev = node;
 	       	node = node->next;
@@ -193,6 +194,7 @@ list_disable_prev(struct list *list)
 #define __list_next(list,x)      ({ list_next(list,x); })
 #define __list_move_before(x, y) ({ list_move_before(x,y); })
 #define __list_node list_node
+#define __list_mov_head(list, x) ({ list_mov_head(list, x); })
 
 /**
  * list_walk  - iterate over list with declared iterator
@@ -342,6 +344,34 @@ list_disable_prev(struct list *list)
 #define list_sort_dsc(list, ...) \
   va_dispatch(insert_sort_dsc,__VA_ARGS__)(list,__list, __VA_ARGS__)
 
+/**
+ * list_top_k  - the k first nodes in ascending order
+ *
+ * @list:       the your list.
+ * @heap:       array of at least @k node pointers, gets the result
+ * @k:          number of nodes to select
+ * @fn:	        the type safe comparator
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ */
+
+#define list_top_k(list, heap, k, ...) \
+  top_k_asc(list, __list, heap, k, __VA_ARGS__)
+
+/**
+ * list_sort_partial  - move the k first nodes sorted to the list head
+ *
+ * @list:       the your list.
+ * @heap:       array of at least @k node pointers
+ * @k:          number of nodes to sort
+ * @fn:	        the type safe comparator
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ */
+
+#define list_sort_partial(list, heap, k, ...) \
+  partial_sort_asc(list, __list, heap, k, __VA_ARGS__)
+
 __END_DECLS
 
 #endif/*__GENERIC_LIST_H__*/
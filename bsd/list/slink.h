@@ -85,6 +85,20 @@ __slist_del(struct snode *node, struct snode *prev)
 	prev->next = node->next;
 }
 
+/* the names <bsd/slist.h> exports, used by mem/block.h and mem/pool.c */
+static inline void
+snode_init(struct snode *snode)
+{
+	__snode_init(snode);
+}
+
+/* links @snode in front of chain @head */
+static inline void
+slist_add(struct snode *head, struct snode *snode)
+{
+	__slist_add(head, snode);
+}
+
 #define __slist_entry(node, type, member) \
 	((type *)((char *)node - offsetof(type, member)))
 
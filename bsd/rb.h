@@ -33,6 +33,7 @@
 #define	__BSD_RB_TREE_H__
 
 #include <sys/cdefs.h>
+#include <stdint.h>
 
 /*
  * A red-black tree is a binary search tree with the node color as an
@@ -61,6 +62,17 @@ struct name {								\
 
 #define RB_BLACK	0
 #define RB_RED		1
+
+/*
+ * Define RB_COMPACT before including this file to keep the color in the 
+ * low bit of the parent pointer, elements are at least pointer aligned so 
+ * the bit is always free. The entry shrinks from 32 to 24 bytes on 64-bit,
+ * for all trees of the compilation unit. RB_PARENT() and RB_COLOR() are 
+ * not lvalues then, use RB_SET_PARENT() and RB_SET_COLOR(). Both keep the
+ * other half of the word, a new element is set with RB_SET_PARENT_COLOR().
+ */
+
+#ifndef RB_COMPACT
 #define RB_ENTRY(type)							\
 struct {								\
 	struct type *rbe_left;		/* left element */		\
@@ -69,35 +81,102 @@ struct {								\
 	int rbe_color;			/* node color */		\
 }
 
-#define RB_LEFT(elm, field)		(elm)->field.rbe_left
-#define RB_RIGHT(elm, field)		(elm)->field.rbe_right
 #define RB_PARENT(elm, field)		(elm)->field.rbe_parent
 #define RB_COLOR(elm, field)		(elm)->field.rbe_color
+#define RB_SET_PARENT(elm, parent, field)	RB_PARENT(elm, field) = (parent)
+#define RB_SET_COLOR(elm, color, field)	RB_COLOR(elm, field) = (color)
+#define RB_SET_PARENT_COLOR(elm, parent, color, field) do {		\
+	RB_SET_PARENT(elm, parent, field);				\
+	RB_SET_COLOR(elm, color, field);				\
+} while (/*CONSTCOND*/ 0)
+#else
+#define RB_ENTRY(type)							\
+struct {								\
+	struct type *rbe_left;		/* left element */		\
+	struct type *rbe_right;		/* right element */		\
+	uintptr_t rbe_parent;		/* parent element | color */	\
+}
+
+#define RB_PARENT(elm, field)						\
+	((__typeof__((elm)->field.rbe_left))				\
+	 ((elm)->field.rbe_parent & ~(uintptr_t)1))
+#define RB_COLOR(elm, field)		((int)((elm)->field.rbe_parent & 1))
+#define RB_SET_PARENT(elm, parent, field)				\
+	(elm)->field.rbe_parent = (uintptr_t)(parent) |			\
+	    ((elm)->field.rbe_parent & 1)
+#define RB_SET_COLOR(elm, color, field)					\
+	(elm)->field.rbe_parent = ((elm)->field.rbe_parent &		\
+	    ~(uintptr_t)1) | (uintptr_t)(color)
+#define RB_SET_PARENT_COLOR(elm, parent, color, field)			\
+	(elm)->field.rbe_parent = (uintptr_t)(parent) | (uintptr_t)(color)
+#endif
+
+#define RB_LEFT(elm, field)		(elm)->field.rbe_left
+#define RB_RIGHT(elm, field)		(elm)->field.rbe_right
 #define RB_ROOT(head)			(head)->rbh_root
 #define RB_EMPTY(head)			(RB_ROOT(head) == NULL)
 
 #define RB_SET(elm, parent, field) do {					\
-	RB_PARENT(elm, field) = parent;					\
+	RB_SET_PARENT_COLOR(elm, parent, RB_RED, field);		\
 	RB_LEFT(elm, field) = RB_RIGHT(elm, field) = NULL;		\
-	RB_COLOR(elm, field) = RB_RED;					\
 } while (/*CONSTCOND*/ 0)
 
 #define RB_SET_BLACKRED(black, red, field) do {				\
-	RB_COLOR(black, field) = RB_BLACK;				\
-	RB_COLOR(red, field) = RB_RED;					\
+	RB_SET_COLOR(black, RB_BLACK, field);				\
+	RB_SET_COLOR(red, RB_RED, field);				\
 } while (/*CONSTCOND*/ 0)
 
+/*
+ * Augmentation
+ *
+ * Define RB_AUGMENT(x) before including this file to keep a summary of 
+ * every subtree in the elements, it recomputes x from x and its children 
+ * and applies to all trees of the compilation unit. The summary of a 
+ * rotated subtree does not change, so rotations update the two rotated 
+ * elements only, inserts and removals update the path up to the root.
+ * RB_AUGMENT_SIZE() and RB_AUGMENT_MAX() are the summaries used by the 
+ * generated order statistics and interval functions below, both can be 
+ * kept at once:
+ *
+ *   #define RB_AUGMENT(x) do { RB_AUGMENT_SIZE(x, entry, size); \
+ *                              RB_AUGMENT_MAX(x, entry, hi, max); } while (0)
+ */
+
 #ifndef RB_AUGMENT
 #define RB_AUGMENT(x)	do {} while (0)
+#define RB_UPDATE_AUGMENT(x, field)	do {} while (0)
+#else
+#define RB_UPDATE_AUGMENT(x, field) do {				\
+	__typeof__(x) __up = (x);					\
+	do {								\
+		RB_AUGMENT(__up);					\
+	} while ((__up = RB_PARENT(__up, field)) != NULL);		\
+} while (/*CONSTCOND*/ 0)
 #endif
 
+#define RB_SIZE(elm, size)		((elm) ? (elm)->size : 0)
+
+#define RB_AUGMENT_SIZE(elm, field, size) do {				\
+	(elm)->size = 1 + RB_SIZE(RB_LEFT(elm, field), size) +		\
+	    RB_SIZE(RB_RIGHT(elm, field), size);			\
+} while (/*CONSTCOND*/ 0)
+
+#define RB_AUGMENT_MAX(elm, field, hi, max) do {			\
+	(elm)->max = (elm)->hi;						\
+	if (RB_LEFT(elm, field) && RB_LEFT(elm, field)->max > (elm)->max)\
+		(elm)->max = RB_LEFT(elm, field)->max;			\
+	if (RB_RIGHT(elm, field) && RB_RIGHT(elm, field)->max > (elm)->max)\
+		(elm)->max = RB_RIGHT(elm, field)->max;			\
+} while (/*CONSTCOND*/ 0)
+
 #define RB_ROTATE_LEFT(head, elm, tmp, field) do {			\
 	(tmp) = RB_RIGHT(elm, field);					\
 	if ((RB_RIGHT(elm, field) = RB_LEFT(tmp, field)) != NULL) {	\
-		RB_PARENT(RB_LEFT(tmp, field), field) = (elm);		\
+		RB_SET_PARENT(RB_LEFT(tmp, field), (elm), field);	\
 	}								\
 	RB_AUGMENT(elm);						\
-	if ((RB_PARENT(tmp, field) = RB_PARENT(elm, field)) != NULL) {	\
+	RB_SET_PARENT(tmp, RB_PARENT(elm, field), field);		\
+	if (RB_PARENT(tmp, field) != NULL) {				\
 		if ((elm) == RB_LEFT(RB_PARENT(elm, field), field))	\
 			RB_LEFT(RB_PARENT(elm, field), field) = (tmp);	\
 		else							\
@@ -105,7 +184,7 @@ struct {								\
 	} else								\
 		(head)->rbh_root = (tmp);				\
 	RB_LEFT(tmp, field) = (elm);					\
-	RB_PARENT(elm, field) = (tmp);					\
+	RB_SET_PARENT(elm, (tmp), field);				\
 	RB_AUGMENT(tmp);						\
 	if ((RB_PARENT(tmp, field)))					\
 		RB_AUGMENT(RB_PARENT(tmp, field));			\
@@ -114,10 +193,11 @@ struct {								\
 #define RB_ROTATE_RIGHT(head, elm, tmp, field) do {			\
 	(tmp) = RB_LEFT(elm, field);					\
 	if ((RB_LEFT(elm, field) = RB_RIGHT(tmp, field)) != NULL) {	\
-		RB_PARENT(RB_RIGHT(tmp, field), field) = (elm);		\
+		RB_SET_PARENT(RB_RIGHT(tmp, field), (elm), field);	\
 	}								\
 	RB_AUGMENT(elm);						\
-	if ((RB_PARENT(tmp, field) = RB_PARENT(elm, field)) != NULL) {	\
+	RB_SET_PARENT(tmp, RB_PARENT(elm, field), field);		\
+	if (RB_PARENT(tmp, field) != NULL) {				\
 		if ((elm) == RB_LEFT(RB_PARENT(elm, field), field))	\
 			RB_LEFT(RB_PARENT(elm, field), field) = (tmp);	\
 		else							\
@@ -125,7 +205,7 @@ struct {								\
 	} else								\
 		(head)->rbh_root = (tmp);				\
 	RB_RIGHT(tmp, field) = (elm);					\
-	RB_PARENT(elm, field) = (tmp);					\
+	RB_SET_PARENT(elm, (tmp), field);				\
 	RB_AUGMENT(tmp);						\
 	if ((RB_PARENT(tmp, field)))					\
 		RB_AUGMENT(RB_PARENT(tmp, field));			\
@@ -145,7 +225,8 @@ struct {								\
 	RB_PROTOTYPE_NFIND(name, type, attr);				\
 	RB_PROTOTYPE_NEXT(name, type, attr);				\
 	RB_PROTOTYPE_PREV(name, type, attr);				\
-	RB_PROTOTYPE_MINMAX(name, type, attr);
+	RB_PROTOTYPE_MINMAX(name, type, attr);				\
+	RB_PROTOTYPE_BUILD(name, type, attr);
 #define RB_PROTOTYPE_INSERT_COLOR(name, type, attr)			\
 	attr void name##_RB_INSERT_COLOR(struct name *, struct type *)
 #define RB_PROTOTYPE_REMOVE_COLOR(name, type, attr)			\
@@ -181,7 +262,8 @@ struct {								\
 	RB_GENERATE_NFIND(name, type, field, cmp, attr)			\
 	RB_GENERATE_NEXT(name, type, field, attr)			\
 	RB_GENERATE_PREV(name, type, field, attr)			\
-	RB_GENERATE_MINMAX(name, type, field, attr)
+	RB_GENERATE_MINMAX(name, type, field, attr)			\
+	RB_GENERATE_BUILD(name, type, field, cmp, attr)
 
 #define RB_GENERATE_INSERT_COLOR(name, type, field, attr)		\
 attr void								\
@@ -194,7 +276,7 @@ name##_RB_INSERT_COLOR(struct name *head, struct type *elm)		\
 		if (parent == RB_LEFT(gparent, field)) {		\
 			tmp = RB_RIGHT(gparent, field);			\
 			if (tmp && RB_COLOR(tmp, field) == RB_RED) {	\
-				RB_COLOR(tmp, field) = RB_BLACK;	\
+				RB_SET_COLOR(tmp, RB_BLACK, field);	\
 				RB_SET_BLACKRED(parent, gparent, field);\
 				elm = gparent;				\
 				continue;				\
@@ -210,7 +292,7 @@ name##_RB_INSERT_COLOR(struct name *head, struct type *elm)		\
 		} else {						\
 			tmp = RB_LEFT(gparent, field);			\
 			if (tmp && RB_COLOR(tmp, field) == RB_RED) {	\
-				RB_COLOR(tmp, field) = RB_BLACK;	\
+				RB_SET_COLOR(tmp, RB_BLACK, field);	\
 				RB_SET_BLACKRED(parent, gparent, field);\
 				elm = gparent;				\
 				continue;				\
@@ -225,7 +307,7 @@ name##_RB_INSERT_COLOR(struct name *head, struct type *elm)		\
 			RB_ROTATE_LEFT(head, gparent, tmp, field);	\
 		}							\
 	}								\
-	RB_COLOR(head->rbh_root, field) = RB_BLACK;			\
+	RB_SET_COLOR(head->rbh_root, RB_BLACK, field);			\
 }
 
 #define RB_GENERATE_REMOVE_COLOR(name, type, field, attr)		\
@@ -246,7 +328,7 @@ name##_RB_REMOVE_COLOR(struct name *head, struct type *parent, struct type *elm)
 			    RB_COLOR(RB_LEFT(tmp, field), field) == RB_BLACK) &&\
 			    (RB_RIGHT(tmp, field) == NULL ||		\
 			    RB_COLOR(RB_RIGHT(tmp, field), field) == RB_BLACK)) {\
-				RB_COLOR(tmp, field) = RB_RED;		\
+				RB_SET_COLOR(tmp, RB_RED, field);	\
 				elm = parent;				\
 				parent = RB_PARENT(elm, field);		\
 			} else {					\
@@ -255,15 +337,15 @@ name##_RB_REMOVE_COLOR(struct name *head, struct type *parent, struct type *elm)
 					struct type *oleft;		\
 					if ((oleft = RB_LEFT(tmp, field)) \
 					    != NULL)			\
-						RB_COLOR(oleft, field) = RB_BLACK;\
-					RB_COLOR(tmp, field) = RB_RED;	\
+						RB_SET_COLOR(oleft, RB_BLACK, field);\
+					RB_SET_COLOR(tmp, RB_RED, field);\
 					RB_ROTATE_RIGHT(head, tmp, oleft, field);\
 					tmp = RB_RIGHT(parent, field);	\
 				}					\
-				RB_COLOR(tmp, field) = RB_COLOR(parent, field);\
-				RB_COLOR(parent, field) = RB_BLACK;	\
+				RB_SET_COLOR(tmp, RB_COLOR(parent, field), field);\
+				RB_SET_COLOR(parent, RB_BLACK, field);	\
 				if (RB_RIGHT(tmp, field))		\
-					RB_COLOR(RB_RIGHT(tmp, field), field) = RB_BLACK;\
+					RB_SET_COLOR(RB_RIGHT(tmp, field), RB_BLACK, field);\
 				RB_ROTATE_LEFT(head, parent, tmp, field);\
 				elm = RB_ROOT(head);			\
 				break;					\
@@ -279,7 +361,7 @@ name##_RB_REMOVE_COLOR(struct name *head, struct type *parent, struct type *elm)
 			    RB_COLOR(RB_LEFT(tmp, field), field) == RB_BLACK) &&\
 			    (RB_RIGHT(tmp, field) == NULL ||		\
 			    RB_COLOR(RB_RIGHT(tmp, field), field) == RB_BLACK)) {\
-				RB_COLOR(tmp, field) = RB_RED;		\
+				RB_SET_COLOR(tmp, RB_RED, field);	\
 				elm = parent;				\
 				parent = RB_PARENT(elm, field);		\
 			} else {					\
@@ -288,15 +370,15 @@ name##_RB_REMOVE_COLOR(struct name *head, struct type *parent, struct type *elm)
 					struct type *oright;		\
 					if ((oright = RB_RIGHT(tmp, field)) \
 					    != NULL)			\
-						RB_COLOR(oright, field) = RB_BLACK;\
-					RB_COLOR(tmp, field) = RB_RED;	\
+						RB_SET_COLOR(oright, RB_BLACK, field);\
+					RB_SET_COLOR(tmp, RB_RED, field);\
 					RB_ROTATE_LEFT(head, tmp, oright, field);\
 					tmp = RB_LEFT(parent, field);	\
 				}					\
-				RB_COLOR(tmp, field) = RB_COLOR(parent, field);\
-				RB_COLOR(parent, field) = RB_BLACK;	\
+				RB_SET_COLOR(tmp, RB_COLOR(parent, field), field);\
+				RB_SET_COLOR(parent, RB_BLACK, field);	\
 				if (RB_LEFT(tmp, field))		\
-					RB_COLOR(RB_LEFT(tmp, field), field) = RB_BLACK;\
+					RB_SET_COLOR(RB_LEFT(tmp, field), RB_BLACK, field);\
 				RB_ROTATE_RIGHT(head, parent, tmp, field);\
 				elm = RB_ROOT(head);			\
 				break;					\
@@ -304,7 +386,7 @@ name##_RB_REMOVE_COLOR(struct name *head, struct type *parent, struct type *elm)
 		}							\
 	}								\
 	if (elm)							\
-		RB_COLOR(elm, field) = RB_BLACK;			\
+		RB_SET_COLOR(elm, RB_BLACK, field);			\
 }
 
 #define RB_GENERATE_REMOVE(name, type, field, attr)			\
@@ -326,7 +408,7 @@ name##_RB_REMOVE(struct name *head, struct type *elm)			\
 		parent = RB_PARENT(elm, field);				\
 		color = RB_COLOR(elm, field);				\
 		if (child)						\
-			RB_PARENT(child, field) = parent;		\
+			RB_SET_PARENT(child, parent, field);		\
 		if (parent) {						\
 			if (RB_LEFT(parent, field) == elm)		\
 				RB_LEFT(parent, field) = child;		\
@@ -346,9 +428,9 @@ name##_RB_REMOVE(struct name *head, struct type *elm)			\
 			RB_AUGMENT(RB_PARENT(old, field));		\
 		} else							\
 			RB_ROOT(head) = elm;				\
-		RB_PARENT(RB_LEFT(old, field), field) = elm;		\
+		RB_SET_PARENT(RB_LEFT(old, field), elm, field);		\
 		if (RB_RIGHT(old, field))				\
-			RB_PARENT(RB_RIGHT(old, field), field) = elm;	\
+			RB_SET_PARENT(RB_RIGHT(old, field), elm, field);\
 		if (parent) {						\
 			left = parent;					\
 			do {						\
@@ -360,13 +442,13 @@ name##_RB_REMOVE(struct name *head, struct type *elm)			\
 	parent = RB_PARENT(elm, field);					\
 	color = RB_COLOR(elm, field);					\
 	if (child)							\
-		RB_PARENT(child, field) = parent;			\
+		RB_SET_PARENT(child, parent, field);			\
 	if (parent) {							\
 		if (RB_LEFT(parent, field) == elm)			\
 			RB_LEFT(parent, field) = child;			\
 		else							\
 			RB_RIGHT(parent, field) = child;		\
-		RB_AUGMENT(parent);					\
+		RB_UPDATE_AUGMENT(parent, field);			\
 	} else								\
 		RB_ROOT(head) = child;					\
 color:									\
@@ -400,9 +482,9 @@ name##_RB_INSERT(struct name *head, struct type *elm)			\
 			RB_LEFT(parent, field) = elm;			\
 		else							\
 			RB_RIGHT(parent, field) = elm;			\
-		RB_AUGMENT(parent);					\
 	} else								\
 		RB_ROOT(head) = elm;					\
+	RB_UPDATE_AUGMENT(elm, field);					\
 	name##_RB_INSERT_COLOR(head, elm);				\
 	return (NULL);							\
 }
@@ -510,6 +592,236 @@ name##_RB_MINMAX(struct name *head, int val)				\
 	return (parent);						\
 }
 
+/*
+ * Bulk construction: RB_BUILD() replaces the tree with a balanced tree of
+ * n elements given in ascending order, RB_BUILD_VINE() does the same for 
+ * elements chained in ascending order through RB_RIGHT(). Every level but 
+ * the last is complete and black, the last is red, so no rotations or 
+ * comparisons are needed and the cost is O(n). RB_VINE() flattens a tree 
+ * back into such a chain. RB_MERGE() moves all elements of src into dst in
+ * O(n + m), elements equal to one already in dst stay in src, as RB_INSERT()
+ * would refuse them.
+ */
+
+#define RB_PROTOTYPE_BUILD(name, type, attr)				\
+	attr struct type *name##_RB_BUILD_SUB(struct type **, size_t,	\
+	    unsigned, unsigned);					\
+	attr void name##_RB_BUILD_VINE(struct name *, struct type *, size_t);\
+	attr void name##_RB_BUILD(struct name *, struct type **, size_t);\
+	attr struct type *name##_RB_VINE(struct name *, size_t *);	\
+	attr size_t name##_RB_MERGE(struct name *, struct name *)
+#define RB_GENERATE_BUILD(name, type, field, cmp, attr)			\
+/* balanced subtree of the next n elements of the vine */		\
+attr struct type *							\
+name##_RB_BUILD_SUB(struct type **vine, size_t n, unsigned depth,	\
+    unsigned red)							\
+{									\
+	struct type *elm, *left, *right;				\
+	int color;							\
+	if (n == 0)							\
+		return (NULL);						\
+	left = name##_RB_BUILD_SUB(vine, (n - 1) / 2, depth + 1, red);	\
+	elm = *vine;							\
+	*vine = RB_RIGHT(elm, field);					\
+	right = name##_RB_BUILD_SUB(vine, n / 2, depth + 1, red);	\
+	color = depth + 1 == red ? RB_RED : RB_BLACK;			\
+	if ((RB_LEFT(elm, field) = left) != NULL)			\
+		RB_SET_PARENT_COLOR(left, elm, color, field);		\
+	if ((RB_RIGHT(elm, field) = right) != NULL)			\
+		RB_SET_PARENT_COLOR(right, elm, color, field);		\
+	RB_AUGMENT(elm);						\
+	return (elm);							\
+}									\
+									\
+attr void								\
+name##_RB_BUILD_VINE(struct name *head, struct type *vine, size_t n)	\
+{									\
+	unsigned red = 0;						\
+	while ((n + 1) >> (red + 1))					\
+		red++;							\
+	RB_ROOT(head) = name##_RB_BUILD_SUB(&vine, n, 0, red);		\
+	if (RB_ROOT(head))						\
+		RB_SET_PARENT_COLOR(RB_ROOT(head), NULL, RB_BLACK, field);\
+}									\
+									\
+attr void								\
+name##_RB_BUILD(struct name *head, struct type **elms, size_t n)	\
+{									\
+	for (size_t i = 0; i + 1 < n; i++)				\
+		RB_RIGHT(elms[i], field) = elms[i + 1];			\
+	if (n)								\
+		RB_RIGHT(elms[n - 1], field) = NULL;			\
+	name##_RB_BUILD_VINE(head, n ? elms[0] : NULL, n);		\
+}									\
+									\
+attr struct type *							\
+name##_RB_VINE(struct name *head, size_t *count)			\
+{									\
+	struct type *vine = NULL, **link = &vine;			\
+	struct type *elm = RB_ROOT(head), *left;			\
+	size_t n = 0;							\
+	while (elm) {							\
+		if ((left = RB_LEFT(elm, field)) != NULL) {		\
+			RB_LEFT(elm, field) = RB_RIGHT(left, field);	\
+			RB_RIGHT(left, field) = elm;			\
+			elm = left;					\
+			continue;					\
+		}							\
+		*link = elm;						\
+		link = &RB_RIGHT(elm, field);				\
+		elm = RB_RIGHT(elm, field);				\
+		n++;							\
+	}								\
+	RB_ROOT(head) = NULL;						\
+	if (count)							\
+		*count = n;						\
+	return (vine);							\
+}									\
+									\
+attr size_t								\
+name##_RB_MERGE(struct name *dst, struct name *src)			\
+{									\
+	struct type *a, *b, *vine = NULL, **link = &vine;		\
+	struct type *dup = NULL, **tail = &dup;				\
+	size_t n = 0, ndup = 0;						\
+	a = name##_RB_VINE(dst, NULL);					\
+	b = name##_RB_VINE(src, NULL);					\
+	while (a || b) {						\
+		int comp = !a ? 1 : !b ? -1 : (cmp)(a, b);		\
+		if (comp == 0) {					\
+			*tail = b;					\
+			tail = &RB_RIGHT(b, field);			\
+			b = RB_RIGHT(b, field);				\
+			ndup++;						\
+			continue;					\
+		}							\
+		if (comp < 0) {						\
+			*link = a;					\
+			a = RB_RIGHT(a, field);				\
+		} else {						\
+			*link = b;					\
+			b = RB_RIGHT(b, field);				\
+		}							\
+		link = &RB_RIGHT(*link, field);				\
+		n++;							\
+	}								\
+	*link = *tail = NULL;						\
+	name##_RB_BUILD_VINE(dst, vine, n);				\
+	name##_RB_BUILD_VINE(src, dup, ndup);				\
+	return (n);							\
+}
+
+/*
+ * Order statistics, @size names the member kept by RB_AUGMENT_SIZE().
+ * RB_RANK() is the position of an element in the tree, RB_NRANK() the 
+ * number of elements less than a search key and RB_SELECT() the element at
+ * a position, all O(log n).
+ */
+
+#define RB_PROTOTYPE_RANK(name, type, attr)				\
+	attr size_t name##_RB_RANK(struct type *);			\
+	attr size_t name##_RB_NRANK(struct name *, struct type *);	\
+	attr struct type *name##_RB_SELECT(struct name *, size_t)
+#define RB_GENERATE_RANK(name, type, field, cmp, size, attr)		\
+attr size_t								\
+name##_RB_RANK(struct type *elm)					\
+{									\
+	size_t rank = RB_SIZE(RB_LEFT(elm, field), size);		\
+	struct type *up;						\
+	for (; (up = RB_PARENT(elm, field)) != NULL; elm = up)		\
+		if (elm == RB_RIGHT(up, field))				\
+			rank += RB_SIZE(RB_LEFT(up, field), size) + 1;	\
+	return (rank);							\
+}									\
+attr size_t								\
+name##_RB_NRANK(struct name *head, struct type *elm)			\
+{									\
+	struct type *tmp = RB_ROOT(head);				\
+	size_t rank = 0;						\
+	while (tmp) {							\
+		if (cmp(elm, tmp) <= 0)					\
+			tmp = RB_LEFT(tmp, field);			\
+		else {							\
+			rank += RB_SIZE(RB_LEFT(tmp, field), size) + 1;	\
+			tmp = RB_RIGHT(tmp, field);			\
+		}							\
+	}								\
+	return (rank);							\
+}									\
+attr struct type *							\
+name##_RB_SELECT(struct name *head, size_t pos)				\
+{									\
+	struct type *tmp = RB_ROOT(head);				\
+	while (tmp) {							\
+		size_t left = RB_SIZE(RB_LEFT(tmp, field), size);	\
+		if (pos < left)						\
+			tmp = RB_LEFT(tmp, field);			\
+		else if (pos == left)					\
+			break;						\
+		else {							\
+			pos -= left + 1;				\
+			tmp = RB_RIGHT(tmp, field);			\
+		}							\
+	}								\
+	return (tmp);							\
+}
+
+/*
+ * Interval trees: elements ordered by the low end @lo, @max names the 
+ * member kept by RB_AUGMENT_MAX() over the high end @hi. Intervals are 
+ * closed. RB_OVERLAP() finds the overlapping interval with the least low 
+ * end in O(log n), RB_OVERLAP_NEXT() the following one, so reporting k 
+ * intervals costs O(k log n).
+ */
+
+#define RB_PROTOTYPE_INTERVAL(name, type, max, attr)			\
+	attr struct type *name##_RB_OVERLAP_FROM(struct type *,		\
+	    __typeof__(((struct type *)0)->max),			\
+	    __typeof__(((struct type *)0)->max));			\
+	attr struct type *name##_RB_OVERLAP_NEXT(struct type *,		\
+	    __typeof__(((struct type *)0)->max),			\
+	    __typeof__(((struct type *)0)->max))
+#define RB_GENERATE_INTERVAL(name, type, field, lo, hi, max, attr)	\
+/* leftmost interval of the subtree at elm which overlaps [l, h] */	\
+attr struct type *							\
+name##_RB_OVERLAP_FROM(struct type *elm, __typeof__((elm)->max) l,	\
+    __typeof__((elm)->max) h)						\
+{									\
+	while (elm) {							\
+		struct type *left = RB_LEFT(elm, field);		\
+		if (left && left->max >= l)				\
+			elm = left;					\
+		else if ((elm)->lo > h)					\
+			return (NULL);					\
+		else if ((elm)->hi >= l)				\
+			return (elm);					\
+		else							\
+			elm = RB_RIGHT(elm, field);			\
+	}								\
+	return (NULL);							\
+}									\
+attr struct type *							\
+name##_RB_OVERLAP_NEXT(struct type *elm, __typeof__((elm)->max) l,	\
+    __typeof__((elm)->max) h)						\
+{									\
+	struct type *up, *res;						\
+	if (RB_RIGHT(elm, field) && RB_RIGHT(elm, field)->max >= l &&	\
+	    (res = name##_RB_OVERLAP_FROM(RB_RIGHT(elm, field), l, h)))	\
+		return (res);						\
+	for (; (up = RB_PARENT(elm, field)) != NULL; elm = up) {	\
+		if (elm != RB_LEFT(up, field))				\
+			continue;					\
+		if (up->lo > h)						\
+			return (NULL);					\
+		if (up->hi >= l)					\
+			return (up);					\
+		if (RB_RIGHT(up, field) && RB_RIGHT(up, field)->max >= l &&\
+		    (res = name##_RB_OVERLAP_FROM(RB_RIGHT(up, field), l, h)))\
+			return (res);					\
+	}								\
+	return (NULL);							\
+}
+
 #define RB_NEGINF	-1
 #define RB_INF	1
 
@@ -521,6 +833,15 @@ name##_RB_MINMAX(struct name *head, int val)				\
 #define RB_PREV(name, x, y)	name##_RB_PREV(y)
 #define RB_MIN(name, x)		name##_RB_MINMAX(x, RB_NEGINF)
 #define RB_MAX(name, x)		name##_RB_MINMAX(x, RB_INF)
+#define RB_BUILD(name, x, e, n)	name##_RB_BUILD(x, e, n)
+#define RB_BUILD_VINE(name, x, y, n)	name##_RB_BUILD_VINE(x, y, n)
+#define RB_VINE(name, x, n)	name##_RB_VINE(x, n)
+#define RB_MERGE(name, x, y)	name##_RB_MERGE(x, y)
+#define RB_RANK(name, x, y)	name##_RB_RANK(y)
+#define RB_NRANK(name, x, y)	name##_RB_NRANK(x, y)
+#define RB_SELECT(name, x, k)	name##_RB_SELECT(x, k)
+#define RB_OVERLAP(name, x, l, h)	name##_RB_OVERLAP_FROM(RB_ROOT(x), l, h)
+#define RB_OVERLAP_NEXT(name, x, y, l, h) name##_RB_OVERLAP_NEXT(y, l, h)
 
 #define RB_FOREACH(x, name, head)					\
 	for ((x) = RB_MIN(name, head);					\
@@ -547,6 +868,11 @@ name##_RB_MINMAX(struct name *head, int val)				\
 	    ((x) != NULL) && ((y) = name##_RB_PREV(x), (x) != NULL);	\
 	     (x) = (y))
 
+#define RB_FOREACH_OVERLAP(x, name, head, l, h)				\
+	for ((x) = RB_OVERLAP(name, head, l, h);			\
+	     (x) != NULL;						\
+	     (x) = name##_RB_OVERLAP_NEXT(x, l, h))
+
 #define RB_FOREACH_REVERSE_SAFE(x, name, head, y)			\
 	for ((x) = RB_MAX(name, head);					\
 	    ((x) != NULL) && ((y) = name##_RB_PREV(x), (x) != NULL);	\
@@ -0,0 +1,255 @@
+/*
+ * Lock-free skip list
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/skiplist.h>
+#include <urcu.h>
+
+/*
+ * An insert links level 0 with one CAS, which is the moment the key exists,
+ * and then the upper levels one by one. A delete marks the upper levels 
+ * top down and level 0 last. A node is freed only when both are done 
+ * (ref drops to 0): until then the inserter may still link an upper level 
+ * it found unmarked a moment ago. The last one unlinks the node from every
+ * level and hands it to call_rcu().
+ */
+
+_Static_assert(sizeof(struct rcu_head) <= 
+               sizeof(((struct skiplist_node *)0)->rcu),
+               "struct rcu_head does not fit into the node");
+
+static __thread u64 skiplist_seed;
+
+static inline int
+skiplist_cas(struct skiplist_node **link, struct skiplist_node *old,
+             struct skiplist_node *new)
+{
+	return __atomic_compare_exchange_n(link, &old, new, 0, 
+	                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline struct skiplist_node *
+skiplist_mark(struct skiplist_node *node)
+{
+	return (struct skiplist_node *)((uintptr_t)node | 1);
+}
+
+static unsigned int
+skiplist_height(void)
+{
+	u64 x = skiplist_seed ? skiplist_seed: (u64)(uintptr_t)&skiplist_seed;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	skiplist_seed = x;
+	return 1 + __builtin_ctzll(x | (1ULL << (2 * (SKIPLIST_LEVELS - 1)))) / 2;
+}
+
+static struct skiplist_node *
+skiplist_node_alloc(u64 key, void *val, unsigned int height)
+{
+	struct skiplist_node *node = mm_alloc(mm_libc(), sizeof(*node) + 
+	                                      height * sizeof(node->next[0]));
+	node->key = key;
+	node->val = val;
+	node->height = height;
+	node->ref = 2;
+	return node;
+}
+
+static void
+skiplist_node_free(struct rcu_head *rcu)
+{
+	mm_free(mm_libc(), __container_of(rcu, struct skiplist_node, rcu));
+}
+
+/* preds and succs of key on every level, unlinks marked nodes on the way */
+static int
+skiplist_search(struct skiplist *list, u64 key,
+                struct skiplist_node **preds, struct skiplist_node **succs)
+{
+	struct skiplist_node *pred, *curr, *succ;
+retry:
+	pred = list->head;
+	for (int level = SKIPLIST_LEVELS - 1; level >= 0; level--) {
+		curr = skiplist_ptr(skiplist_load(&pred->next[level]));
+		while (curr) {
+			succ = skiplist_load(&curr->next[level]);
+			if (skiplist_marked(succ)) {
+				succ = skiplist_ptr(succ);
+				if (!skiplist_cas(&pred->next[level], curr, succ))
+					goto retry;
+				curr = succ;
+				continue;
+			}
+			if (curr->key >= key)
+				break;
+			pred = curr;
+			curr = succ;
+		}
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+	return curr && curr->key == key;
+}
+
+/*
+ * Removes a deleted node from every level. A late upper level link may put
+ * it behind another node with the same key, so the walk passes equal keys
+ * and descends from the last smaller one.
+ */
+static void
+skiplist_unlink(struct skiplist *list, struct skiplist_node *node)
+{
+	struct skiplist_node *pred, *prev, *curr, *succ;
+	u64 key = node->key;
+retry:
+	pred = list->head;
+	for (int level = SKIPLIST_LEVELS - 1; level >= 0; level--) {
+		prev = pred;
+		curr = skiplist_ptr(skiplist_load(&prev->next[level]));
+		while (curr && curr->key <= key) {
+			succ = skiplist_load(&curr->next[level]);
+			if (skiplist_marked(succ)) {
+				succ = skiplist_ptr(succ);
+				if (!skiplist_cas(&prev->next[level], curr, succ))
+					goto retry;
+				if (curr == node)
+					break;
+				curr = succ;
+				continue;
+			}
+			if (curr->key < key)
+				pred = curr;
+			prev = curr;
+			curr = succ;
+		}
+	}
+}
+
+static void
+skiplist_put(struct skiplist *list, struct skiplist_node *node)
+{
+	if (__atomic_sub_fetch(&node->ref, 1, __ATOMIC_ACQ_REL))
+		return;
+	skiplist_unlink(list, node);
+	call_rcu((struct rcu_head *)node->rcu, skiplist_node_free);
+}
+
+void
+skiplist_init(struct skiplist *list)
+{
+	list->head = skiplist_node_alloc(0, NULL, SKIPLIST_LEVELS);
+	for (unsigned int level = 0; level < SKIPLIST_LEVELS; level++)
+		list->head->next[level] = NULL;
+}
+
+void
+skiplist_fini(struct skiplist *list)
+{
+	struct skiplist_node *node = list->head, *next;
+	for (; node; node = next) {
+		next = skiplist_ptr(node->next[0]);
+		mm_free(mm_libc(), node);
+	}
+	list->head = NULL;
+	rcu_barrier();
+}
+
+int
+skiplist_insert(struct skiplist *list, u64 key, void *val)
+{
+	struct skiplist_node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+	struct skiplist_node *node = NULL, *next;
+	unsigned int height = skiplist_height();
+
+	for (;;) {
+		if (skiplist_search(list, key, preds, succs)) {
+			__atomic_store_n(&succs[0]->val, val, __ATOMIC_RELEASE);
+			if (node)
+				mm_free(mm_libc(), node);
+			return 0;
+		}
+		if (!node)
+			node = skiplist_node_alloc(key, val, height);
+		for (unsigned int level = 0; level < height; level++)
+			node->next[level] = succs[level];
+		if (skiplist_cas(&preds[0]->next[0], succs[0], node))
+			break;
+	}
+
+	for (unsigned int level = 1; level < height; level++) {
+		for (;;) {
+			next = skiplist_load(&node->next[level]);
+			if (skiplist_marked(next))
+				goto done;
+			if (next != succs[level] && 
+			    !skiplist_cas(&node->next[level], next, succs[level]))
+				goto done;
+			if (skiplist_cas(&preds[level]->next[level], succs[level], node))
+				break;
+			if (!skiplist_search(list, key, preds, succs) || succs[0] != node)
+				goto done;
+		}
+	}
+done:
+	skiplist_put(list, node);
+	return 1;
+}
+
+int
+skiplist_del(struct skiplist *list, u64 key, void **val)
+{
+	struct skiplist_node *preds[SKIPLIST_LEVELS], *succs[SKIPLIST_LEVELS];
+	struct skiplist_node *node, *next;
+
+	if (!skiplist_search(list, key, preds, succs))
+		return 0;
+
+	node = succs[0];
+	for (unsigned int level = node->height - 1; level > 0; level--) {
+		do {
+			next = skiplist_load(&node->next[level]);
+		} while (!skiplist_marked(next) && 
+		         !skiplist_cas(&node->next[level], next, skiplist_mark(next)));
+	}
+
+	do {
+		next = skiplist_load(&node->next[0]);
+		if (skiplist_marked(next))
+			return 0;
+	} while (!skiplist_cas(&node->next[0], next, skiplist_mark(next)));
+
+	if (val)
+		*val = __atomic_load_n(&node->val, __ATOMIC_ACQUIRE);
+	skiplist_put(list, node);
+	return 1;
+}
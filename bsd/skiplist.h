@@ -0,0 +1,199 @@
+/*
+ * Lock-free skip list
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SKIPLIST_H__
+#define __GENERIC_SKIPLIST_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/*
+ * Lock-free skip list
+ *
+ * Ordered map of u64 keys to pointers that many threads can read and 
+ * update at once without locks. Every level is a Harris linked list: a 
+ * node is deleted by setting the low bit of its next pointers, top level 
+ * first, and the node which wins the mark of level 0 owns the delete. Any
+ * thread which walks over a marked node unlinks it with a CAS.
+ *
+ * Lookups, seeks and iteration never write and never retry: they walk 
+ * through marked nodes, whose next pointers stay valid, and test the mark 
+ * of the result only. Inserts and deletes retry when a CAS loses.
+ *
+ * Memory is reclaimed with liburcu. All functions except init and fini
+ * must run in a thread registered with rcu_register_thread(), inside 
+ * rcu_read_lock(). Nodes returned by skiplist_seek() and skiplist_next()
+ * stay valid until rcu_read_unlock(). A deleted node is passed to 
+ * call_rcu() only after it is unlinked from every level.
+ *
+ * Nodes are allocated from mm_libc(), because call_rcu() frees them on its
+ * own thread.
+ *
+ * Node height is 1 + k with probability 4^-k, 1.33 next pointers per node 
+ * on average.
+ *
+ * Time complexity:  O(log n) expected find, insert and delete
+ * Space complexity: Θ(n)
+ */
+
+#define SKIPLIST_LEVELS 16
+
+struct skiplist_node {
+	u64 key;
+	void *val;
+	void *rcu[2];         /* struct rcu_head, used once unlinked       */
+	u32 height;
+	u32 ref;              /* inserter and deleter still at work        */
+	struct skiplist_node *next[];
+};
+
+struct skiplist {
+	struct skiplist_node *head;
+};
+
+void
+skiplist_init(struct skiplist *list);
+
+/* no concurrent users, waits for the nodes already passed to call_rcu() */
+void
+skiplist_fini(struct skiplist *list);
+
+/**
+ * skiplist_insert - insert or replace
+ *
+ * @list:       the skip list
+ * @key:        the key
+ * @val:        the value
+ *
+ * Returns 1 when the key was added, 0 when its value was replaced.
+ */
+
+int
+skiplist_insert(struct skiplist *list, u64 key, void *val);
+
+/**
+ * skiplist_del - remove a key
+ *
+ * @list:       the skip list
+ * @key:        the key
+ * @val:        optional, gets the removed value
+ *
+ * Returns 1 when this call removed the key, 0 when it was not there.
+ */
+
+int
+skiplist_del(struct skiplist *list, u64 key, void **val);
+
+#define skiplist_marked(ptr) ((uintptr_t)(ptr) & 1)
+#define skiplist_ptr(ptr) \
+	((struct skiplist_node *)((uintptr_t)(ptr) & ~(uintptr_t)1))
+
+static inline struct skiplist_node *
+skiplist_load(struct skiplist_node *const *link)
+{
+	return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+}
+
+/* first node on level 0 after @node which is not deleted */
+static inline struct skiplist_node *
+skiplist_next(struct skiplist_node *node)
+{
+	struct skiplist_node *curr = skiplist_ptr(skiplist_load(&node->next[0]));
+	while (curr) {
+		struct skiplist_node *succ = skiplist_load(&curr->next[0]);
+		if (!skiplist_marked(succ))
+			return curr;
+		curr = skiplist_ptr(succ);
+	}
+	return NULL;
+}
+
+/**
+ * skiplist_seek - first node with a key not less than @key
+ *
+ * @list:       the skip list
+ * @key:        the key
+ *
+ * Returns NULL when every key is less than @key.
+ */
+
+static inline struct skiplist_node *
+skiplist_seek(struct skiplist *list, u64 key)
+{
+	struct skiplist_node *pred = list->head, *curr = NULL, *succ;
+	for (int level = SKIPLIST_LEVELS - 1; level >= 0; level--) {
+		curr = skiplist_ptr(skiplist_load(&pred->next[level]));
+		while (curr && curr->key < key) {
+			pred = curr;
+			curr = skiplist_ptr(skiplist_load(&curr->next[level]));
+		}
+	}
+	while (curr && skiplist_marked(succ = skiplist_load(&curr->next[0])))
+		curr = skiplist_ptr(succ);
+	return curr;
+}
+
+/**
+ * skiplist_find - value of a key
+ *
+ * @list:       the skip list
+ * @key:        the key
+ * @val:        gets the value when found
+ *
+ * Returns 1 when the key was found.
+ */
+
+static inline int
+skiplist_find(struct skiplist *list, u64 key, void **val)
+{
+	struct skiplist_node *node = skiplist_seek(list, key);
+	if (!node || node->key != key)
+		return 0;
+	if (val)
+		*val = __atomic_load_n(&node->val, __ATOMIC_ACQUIRE);
+	return 1;
+}
+
+#define skiplist_first(list) skiplist_next((list)->head)
+
+#define skiplist_key(node) ((node)->key)
+#define skiplist_val(node) __atomic_load_n(&(node)->val, __ATOMIC_ACQUIRE)
+
+#define skiplist_walk(list, node) \
+	for (struct skiplist_node *node = skiplist_first(list); node; \
+	     node = skiplist_next(node))
+
+/* nodes with keys in [lo, hi] */
+#define skiplist_walk_range(list, node, lo, hi) \
+	for (struct skiplist_node *node = skiplist_seek(list, lo); \
+	     node && node->key <= (hi); node = skiplist_next(node))
+
+__END_DECLS
+
+#endif
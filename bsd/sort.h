@@ -35,6 +35,44 @@
 #define SORT_MERGE_BOTTOM_UP_SHIFT 9
 #endif
 
+#ifndef SORT_NATURAL_MINRUN
+#define SORT_NATURAL_MINRUN 16
+#endif
+#define SORT_NATURAL_STACK 128
+
+/* used internally, cmp of nodes with optional container type and member */
+#define __sort_cmp(a, b, ...) \
+	va_dispatch(__sort_cmp,__VA_ARGS__)(a, b, __VA_ARGS__)
+#define __sort_cmp1(a, b, cmp) cmp(a, b)
+#define __sort_cmp3(a, b, cmp, type, member) \
+	container_cmp(cmp, a, b, type, member)
+
+/**
+ * slist_merge_sorted_asc - merge two sorted NULL-terminated runs
+ *
+ * @a:          the first run, wins ties
+ * @b:          the second run
+ * @cmp:        the type safe cmp
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ *
+ * Runs are struct node chains linked by next only. Returns the head.
+ */
+
+#define slist_merge_sorted_asc(a, b, ...) \
+({ \
+	struct node *__ma = (a), *__mb = (b), __mh, *__mt = &__mh; \
+	while (__ma && __mb) { \
+		if (__sort_cmp(__mb, __ma, __VA_ARGS__) < 0) { \
+			__mt->next = __mb; __mt = __mb; __mb = __mb->next; \
+		} else { \
+			__mt->next = __ma; __mt = __ma; __ma = __ma->next; \
+		} \
+	} \
+	__mt->next = __ma ? __ma: __mb; \
+	__mh.next; \
+})
+
 /**
  * insert_sort
  *
@@ -477,6 +515,198 @@
 })
 
 
+/**
+ * merge_sort_natural_asc - adaptive natural merge sort
+ *
+ * sort container items in ascending order
+ *
+ * @self:       the container
+ * @prefix      the prefix of _disable_prev() and _enable_prev() methods
+ * @cmp:        the type safe cmp
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ *
+ * Timsort on a list. The list is cut into existing runs, strictly 
+ * descending runs are reversed in place and runs shorter than 
+ * SORT_NATURAL_MINRUN are extended by insertion. Runs are kept on a stack 
+ * whose lengths grow faster than Fibonacci numbers (Auger, Jugé, Nicaud, 
+ * Pivoteau: On the Worst-Case Complexity of TimSort), so merges stay 
+ * balanced and the stack depth is logarithmic. Stable.
+ *
+ * slist_sort_natural_asc() sorts a NULL-terminated chain linked by next 
+ * only and returns its new head.
+ *
+ * Time complexity:  O(n log r) for r runs, Θ(n) when sorted or reversed
+ * Space complexity: O(log n)
+ */
+
+#define __merge_natural_collapse(st, n, ...) \
+({ \
+	while ((n) > 1) { \
+		unsigned __i = (n) - 2; \
+		if ((n) > 2 && st[(n) - 3].len <= st[(n) - 2].len + st[(n) - 1].len) { \
+			if (st[(n) - 3].len < st[(n) - 1].len) \
+				__i = (n) - 3; \
+		} else if ((n) > 3 && \
+		           st[(n) - 4].len <= st[(n) - 3].len + st[(n) - 2].len) { \
+			if (st[(n) - 3].len < st[(n) - 1].len) \
+				__i = (n) - 3; \
+		} else if (st[(n) - 2].len > st[(n) - 1].len) { \
+			break; \
+		} \
+		st[__i].head = slist_merge_sorted_asc(st[__i].head, \
+		               st[__i + 1].head, __VA_ARGS__); \
+		st[__i].len += st[__i + 1].len; \
+		if (__i + 2 < (n)) \
+			st[__i + 1] = st[__i + 2]; \
+		(n)--; \
+	} \
+})
+
+#define slist_sort_natural_asc(chain, ...) \
+({ \
+	struct { struct node *head; size_t len; } __st[SORT_NATURAL_STACK]; \
+	unsigned __n = 0; \
+	struct node *__x = (chain); \
+	while (__x) { \
+		struct node *__h = __x, *__t = __x, *__y = __x->next; \
+		size_t __len = 1; \
+		__x->next = NULL; \
+		if (__y && __sort_cmp(__y, __t, __VA_ARGS__) < 0) { \
+			for (struct node *__p = __t; __y && \
+			     __sort_cmp(__y, __p, __VA_ARGS__) < 0; __len++) { \
+				struct node *__z = __y->next; \
+				__y->next = __h; __h = __p = __y; __y = __z; \
+			} \
+		} else { \
+			while (__y && __sort_cmp(__y, __t, __VA_ARGS__) >= 0) { \
+				__t->next = __y; __t = __y; __y = __y->next; __len++; \
+			} \
+			__t->next = NULL; \
+		} \
+		for (; __len < SORT_NATURAL_MINRUN && __y; __len++) { \
+			struct node *__z = __y, *__p = __h; \
+			__y = __y->next; \
+			if (__sort_cmp(__z, __t, __VA_ARGS__) >= 0) { \
+				__t->next = __z; __t = __z; __z->next = NULL; \
+			} else if (__sort_cmp(__z, __h, __VA_ARGS__) < 0) { \
+				__z->next = __h; __h = __z; \
+			} else { \
+				while (__sort_cmp(__p->next, __z, __VA_ARGS__) <= 0) \
+					__p = __p->next; \
+				__z->next = __p->next; __p->next = __z; \
+			} \
+		} \
+		__st[__n].head = __h; __st[__n].len = __len; __n++; \
+		__merge_natural_collapse(__st, __n, __VA_ARGS__); \
+		__x = __y; \
+	} \
+	for (; __n > 1; __n--) \
+		__st[__n - 2].head = slist_merge_sorted_asc(__st[__n - 2].head, \
+		                     __st[__n - 1].head, __VA_ARGS__); \
+	__n ? __st[0].head: NULL; \
+})
+
+#define merge_sort_natural_asc(self, prefix, ...) \
+({ \
+	if (!list_empty(self) && !list_singular(self)) \
+		prefix##_enable_prev(self, slist_sort_natural_asc( \
+		                     prefix##_disable_prev(self), __VA_ARGS__)); \
+})
+
+/* used internally, max-heap of nodes for top_k_asc() */
+#define __heap_sift_down(heap, n, i, ...) \
+({ \
+	size_t __i = (i), __c; \
+	__typeof__((heap)[0]) __v = (heap)[__i]; \
+	while ((__c = 2 * __i + 1) < (n)) { \
+		if (__c + 1 < (n) && \
+		    __sort_cmp((heap)[__c], (heap)[__c + 1], __VA_ARGS__) < 0) \
+			__c++; \
+		if (__sort_cmp(__v, (heap)[__c], __VA_ARGS__) >= 0) \
+			break; \
+		(heap)[__i] = (heap)[__c]; __i = __c; \
+	} \
+	(heap)[__i] = __v; \
+})
+
+#define __heap_sift_up(heap, i, ...) \
+({ \
+	size_t __i = (i); \
+	__typeof__((heap)[0]) __v = (heap)[__i]; \
+	while (__i && __sort_cmp((heap)[(__i - 1) / 2], __v, __VA_ARGS__) < 0) { \
+		(heap)[__i] = (heap)[(__i - 1) / 2]; __i = (__i - 1) / 2; \
+	} \
+	(heap)[__i] = __v; \
+})
+
+/**
+ * top_k_asc - the k first container items in ascending order
+ *
+ * @self:       the container
+ * @prefix      the prefix of _first() and _next() methods
+ * @heap:       array of at least @k node pointers, gets the result
+ * @k:          number of items to select
+ * @cmp:        the type safe cmp
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ *
+ * A bounded max-heap of @k nodes keeps the smallest items seen so far, 
+ * an item which is not smaller than the top of the heap costs one compare. 
+ * The selected nodes are stored sorted in @heap, the container is left 
+ * unchanged. Returns the number of selected nodes. Not stable.
+ *
+ * Time complexity:  O(n log k)
+ * Space complexity: Θ(k)
+ */
+
+#define top_k_asc(self, prefix, heap, k, ...) \
+({ \
+	size_t __k = (k), __len = 0; \
+	for (prefix##_node *__x = prefix##_first(self); __x && __k; \
+	     __x = prefix##_next(self, __x)) { \
+		if (__len < __k) { \
+			(heap)[__len] = __x; \
+			__heap_sift_up(heap, __len, __VA_ARGS__); \
+			__len++; \
+		} else if (__sort_cmp(__x, (heap)[0], __VA_ARGS__) < 0) { \
+			(heap)[0] = __x; \
+			__heap_sift_down(heap, __k, 0, __VA_ARGS__); \
+		} \
+	} \
+	for (size_t __n = __len; __n > 1; ) { \
+		prefix##_node *__t = (heap)[0]; \
+		(heap)[0] = (heap)[--__n]; (heap)[__n] = __t; \
+		__heap_sift_down(heap, __n, 0, __VA_ARGS__); \
+	} \
+	__len; \
+})
+
+/**
+ * partial_sort_asc - move the k first items sorted to the front
+ *
+ * @self:       the container
+ * @prefix      the prefix of _first(), _next() and _mov_head() methods
+ * @heap:       array of at least @k node pointers
+ * @k:          number of items to sort
+ * @cmp:        the type safe cmp
+ * @type:       the optional structure type
+ * @member:     the optional name of the node within the struct.
+ *
+ * The rest of the container keeps its relative order.
+ *
+ * Time complexity:  O(n log k)
+ * Space complexity: Θ(k)
+ */
+
+#define partial_sort_asc(self, prefix, heap, k, ...) \
+({ \
+	size_t __m = top_k_asc(self, prefix, heap, k, __VA_ARGS__); \
+	for (size_t __j = __m; __j > 0; __j--) \
+		prefix##_mov_head(self, (heap)[__j - 1]); \
+	__m; \
+})
+
 /**
  * invers_asc - inversion count in ascending order
  *
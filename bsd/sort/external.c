@@ -0,0 +1,344 @@
+/*
+ * External merge sort for fixed-size records
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/sort/radix.h>
+#include <bsd/sort/external.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+
+struct ext_run {
+	off_t pos, end;       /* unread part of the run in the file            */
+	byte *buf, *cur, *lim;
+};
+
+struct ext_sort {
+	struct ext_run *run;
+	unsigned int *tree;   /* loser tree, tree[0] is unused                 */
+	unsigned int k;
+	int fd;
+	size_t size, offset, bytes, block;
+	struct sort_external_stat *stat;
+};
+
+static ssize_t
+ext_read(int fd, void *addr, size_t len, off_t pos)
+{
+	size_t done = 0;
+	while (done < len) {
+		ssize_t rv = pos < 0 ? read(fd, (byte *)addr + done, len - done):
+		             pread(fd, (byte *)addr + done, len - done, pos + done);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv < 0)
+			return -1;
+		if (!rv)
+			break;
+		done += rv;
+	}
+	return done;
+}
+
+static int
+ext_write(int fd, const void *addr, size_t len)
+{
+	while (len) {
+		ssize_t rv = write(fd, addr, len);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv < 0)
+			return -1;
+		addr = (const byte *)addr + rv;
+		len -= rv;
+	}
+	return 0;
+}
+
+static int
+ext_tmpfile(const char *tmpdir)
+{
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/sort.XXXXXX", tmpdir ? tmpdir: "/tmp");
+	int fd = mkstemp(path);
+	if (fd != -1)
+		unlink(path);
+	return fd;
+}
+
+/* refills the buffer of run @i, the run is empty when cur == lim */
+static int
+ext_fill(struct ext_sort *ext, unsigned int i)
+{
+	struct ext_run *run = &ext->run[i];
+	size_t len = __min((off_t)ext->block, run->end - run->pos);
+	ssize_t rv = ext_read(ext->fd, run->buf, len, run->pos);
+	if (rv < 0)
+		return -1;
+	if ((size_t)rv != len)
+		return errno = EIO, -1;
+
+	run->pos += len;
+	run->cur = run->buf;
+	run->lim = run->buf + len;
+	ext->stat->bytes_read += len;
+#ifdef POSIX_FADV_WILLNEED
+	if (run->pos < run->end)
+		posix_fadvise(ext->fd, run->pos, ext->block, POSIX_FADV_WILLNEED);
+#endif
+	return 0;
+}
+
+/* record of run @a goes before record of run @b, empty runs go last */
+static inline int
+ext_less(struct ext_sort *ext, unsigned int a, unsigned int b)
+{
+	struct ext_run *x = &ext->run[a], *y = &ext->run[b];
+	if (x->cur == x->lim)
+		return 0;
+	if (y->cur == y->lim)
+		return 1;
+	int rv = memcmp(x->cur + ext->offset, y->cur + ext->offset, ext->bytes);
+	return rv < 0 || (!rv && a < b);
+}
+
+static unsigned int
+ext_build(struct ext_sort *ext, unsigned int node)
+{
+	if (node >= ext->k)
+		return node - ext->k;
+	unsigned int l = ext_build(ext, 2 * node);
+	unsigned int r = ext_build(ext, 2 * node + 1);
+	if (ext_less(ext, l, r))
+		return ext->tree[node] = r, l;
+	return ext->tree[node] = l, r;
+}
+
+/*
+ * Merges @k runs of @ext->fd into @out. @buf holds the output block followed
+ * by one block for every run.
+ */
+
+static int
+ext_merge(struct ext_sort *ext, struct ext_run *runs, unsigned int k, int out,
+          byte *buf)
+{
+	byte *o = buf, *olim = buf + ext->block;
+	ext->run = runs;
+	ext->k = k;
+
+	for (unsigned int i = 0; i < k; i++) {
+		runs[i].buf = buf + (size_t)(i + 1) * ext->block;
+		if (ext_fill(ext, i))
+			return -1;
+	}
+
+	unsigned int win = k > 1 ? ext_build(ext, 1): 0;
+	for (;;) {
+		struct ext_run *run = &runs[win];
+		if (run->cur == run->lim)
+			break;
+		if (o == olim) {
+			if (ext_write(out, buf, o - buf))
+				return -1;
+			ext->stat->bytes_written += o - buf;
+			o = buf;
+		}
+		memcpy(o, run->cur, ext->size);
+		o += ext->size;
+		run->cur += ext->size;
+		if (run->cur == run->lim && run->pos < run->end && ext_fill(ext, win))
+			return -1;
+
+		for (unsigned int n = (win + k) / 2; n > 0; n /= 2)
+			if (ext_less(ext, ext->tree[n], win)) {
+				unsigned int t = ext->tree[n];
+				ext->tree[n] = win;
+				win = t;
+			}
+	}
+
+	if (ext_write(out, buf, o - buf))
+		return -1;
+	ext->stat->bytes_written += o - buf;
+	return 0;
+}
+
+/*
+ * Sorts the rest of the input chunk by chunk and appends the runs to @fd 
+ * and @runs, which holds @nruns runs in an array of @alloc.
+ */
+
+static ssize_t
+ext_runs(struct ext_sort *ext, int in, int fd, byte *chunk, size_t count,
+         struct ext_run **runs, size_t nruns, size_t alloc, struct mm *mm)
+{
+	off_t pos = (*runs)[nruns - 1].end;
+
+	for (;;) {
+		ssize_t rv = ext_read(in, chunk, count * ext->size, -1);
+		if (rv < 0)
+			return -1;
+		if (rv % ext->size)
+			return errno = EINVAL, -1;
+		if (!rv)
+			break;
+
+		size_t n = rv / ext->size;
+		ext->stat->bytes_read += rv;
+		ext->stat->records += n;
+		radix_sort_msd(chunk, n, ext->size, ext->offset, ext->bytes, mm);
+
+		if (nruns == alloc) {
+			alloc *= 2;
+			*runs = mm_realloc(mm, *runs, alloc * sizeof(**runs));
+		}
+		(*runs)[nruns++] = (struct ext_run) { .pos = pos, .end = pos + rv };
+		if (ext_write(fd, chunk, rv))
+			return -1;
+		ext->stat->bytes_written += rv;
+		pos += rv;
+		if ((size_t)rv < count * ext->size)
+			break;
+	}
+
+	return nruns;
+}
+
+int
+sort_external(int in, int out, size_t size, size_t offset, size_t bytes,
+              size_t memory, const char *tmpdir, struct mm *mm,
+              struct sort_external_stat *stat)
+{
+	struct sort_external_stat dummy;
+	struct ext_sort ext = {
+		.size = size, .offset = offset, .bytes = bytes, .fd = -1,
+		.stat = stat ? stat: &dummy
+	};
+	memset(ext.stat, 0, sizeof(*ext.stat));
+
+	size_t count = __max(memory / 2 / size, 1);
+	byte *chunk = mm_alloc(mm, count * size);
+	struct ext_run *runs = NULL;
+	int fd[2] = { -1, -1 }, rv = -1;
+
+	/* try to do it in memory first, a full chunk means we have to spill */
+	ssize_t n = ext_read(in, chunk, count * size, -1);
+	if (n < 0)
+		goto out;
+	if (n % size) {
+		errno = EINVAL;
+		goto out;
+	}
+	if ((size_t)n < count * size) {
+		ext.stat->bytes_read = n;
+		ext.stat->records = n / size;
+		radix_sort_msd(chunk, n / size, size, offset, bytes, mm);
+		if (!(rv = ext_write(out, chunk, n)))
+			ext.stat->bytes_written = n, ext.stat->runs = 1;
+		goto out;
+	}
+
+	if ((fd[0] = ext_tmpfile(tmpdir)) == -1)
+		goto out;
+	if ((fd[1] = ext_tmpfile(tmpdir)) == -1)
+		goto out;
+
+	/* the first chunk is in the buffer already */
+	ext.stat->bytes_read = n;
+	ext.stat->records = count;
+	radix_sort_msd(chunk, count, size, offset, bytes, mm);
+	if (ext_write(fd[0], chunk, n))
+		goto out;
+	ext.stat->bytes_written = n;
+
+	runs = mm_alloc(mm, 16 * sizeof(*runs));
+	runs[0] = (struct ext_run) { .pos = 0, .end = n };
+	ssize_t nruns = ext_runs(&ext, in, fd[0], chunk, count, &runs, 1, 16, mm);
+	if (nruns < 0)
+		goto out;
+
+	mm_free(mm, chunk);
+	chunk = NULL;
+
+	/* one output buffer and a buffer per run, big enough to keep reads long */
+	ext.block = memory / (nruns + 1);
+	ext.block = __max(ext.block, (size_t)SORT_EXTERNAL_BLOCK / 16);
+	ext.block = __min(ext.block, (size_t)SORT_EXTERNAL_BLOCK);
+	ext.block = __min(ext.block, memory / 3);
+	ext.block = __max(ext.block / size, 1) * size;
+	size_t fanin = __max(memory / ext.block, 3) - 1;
+	size_t ways = __min(fanin, (size_t)nruns);
+
+	byte *buf = mm_alloc(mm, (ways + 1) * ext.block);
+	ext.tree = mm_alloc(mm, ways * sizeof(unsigned int));
+	ext.stat->runs = nruns;
+
+	/* merge groups of consecutive runs until one pass is left */
+	while ((size_t)nruns > fanin) {
+		off_t pos = 0;
+		ssize_t next = 0;
+		ext.fd = fd[0];
+		if (ftruncate(fd[1], 0) || lseek(fd[1], 0, SEEK_SET))
+			goto done;
+		for (ssize_t i = 0; i < nruns; i += fanin, next++) {
+			unsigned int k = __min((ssize_t)fanin, nruns - i);
+			off_t len = runs[i + k - 1].end - runs[i].pos;
+			if (ext_merge(&ext, runs + i, k, fd[1], buf))
+				goto done;
+			runs[next] = (struct ext_run) { .pos = pos, .end = pos + len };
+			pos += len;
+		}
+		nruns = next;
+		int t = fd[0]; fd[0] = fd[1]; fd[1] = t;
+		ext.stat->passes++;
+	}
+
+	ext.fd = fd[0];
+	rv = ext_merge(&ext, runs, nruns, out, buf);
+	ext.stat->passes++;
+done:
+	mm_free(mm, ext.tree);
+	mm_free(mm, buf);
+out:
+	if (chunk)
+		mm_free(mm, chunk);
+	if (runs)
+		mm_free(mm, runs);
+	for (int i = 0; i < 2; i++)
+		if (fd[i] != -1)
+			close(fd[i]);
+	return rv;
+}
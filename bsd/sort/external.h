@@ -0,0 +1,95 @@
+/*
+ * External merge sort for fixed-size records
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_EXTERNAL_H__
+#define __GENERIC_SORT_EXTERNAL_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * External merge sort
+ *
+ * Sorts a file of fixed-size records by a byte-string key in memcmp() order
+ * when the file does not fit into memory. The input is read in chunks of 
+ * half the memory budget, every chunk is sorted with radix_sort_msd() (the 
+ * other half is its scratch copy) and written as one sequential run into an
+ * unlinked temporary file. Runs are merged with a loser tree, which needs 
+ * log2(k) key compares per record for k runs. Every run is read through its 
+ * own buffer of 64 KiB to SORT_EXTERNAL_BLOCK bytes and the next block of 
+ * each run is announced to the kernel with posix_fadvise(), so reads of the 
+ * following block overlap with merging. 
+ * When there are more runs than buffers fit into the budget, consecutive 
+ * runs are merged in passes first. Stable.
+ *
+ * Input which fits into one chunk is sorted in memory and written out.
+ *
+ * Time complexity:  Θ(n log n)
+ * I/O complexity:   Θ(n * (1 + merge passes))
+ * Space complexity: @memory bytes and a temporary file of the input size
+ */
+
+#define SORT_EXTERNAL_BLOCK (1 << 20)
+
+struct sort_external_stat {
+	u64 records;
+	u64 runs;
+	u64 passes;
+	u64 bytes_read;
+	u64 bytes_written;
+};
+
+/**
+ * sort_external - sort records from one file descriptor into another
+ *
+ * @in:         input, read sequentially
+ * @out:        output, written sequentially
+ * @size:       record size
+ * @offset:     offset of the key in the record
+ * @bytes:      key length, compared as memcmp()
+ * @memory:     memory budget in bytes
+ * @tmpdir:     directory for the temporary run files, NULL for /tmp
+ * @mm:         memory context for the buffers
+ * @stat:       optional counters
+ *
+ * Returns 0 on success, -1 with errno set on an I/O error, EINVAL when the
+ * input does not end on a record boundary.
+ */
+
+int
+sort_external(int in, int out, size_t size, size_t offset, size_t bytes,
+              size_t memory, const char *tmpdir, struct mm *mm,
+              struct sort_external_stat *stat);
+
+__END_DECLS
+
+#endif
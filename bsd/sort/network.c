@@ -0,0 +1,281 @@
+/*
+ * Sorting networks for small arrays
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/sort/network.h>
+#include <string.h>
+#include <float.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static inline unsigned int
+sort_network_size(unsigned int count, unsigned int lanes)
+{
+	unsigned int size = lanes;
+	while (size < count)
+		size <<= 1;
+	return size;
+}
+
+/*
+ * Element i of a bitonic stage (k, j) keeps the minimum of the pair 
+ * (i, i ^ j) when (i & j) == 0 matches (i & k) == 0.
+ */
+
+#define DEFINE_SORT_NETWORK_SCALAR(name, type) \
+static inline void \
+name(type *a, unsigned int size) \
+{ \
+	for (unsigned int k = 2; k <= size; k <<= 1) \
+	for (unsigned int j = k >> 1; j; j >>= 1) \
+	for (unsigned int b = 0; b < size; b += 2 * j) { \
+		type *lo = a + b, *hi = a + b + j; \
+		if (b & k) \
+			lo = a + b + j, hi = a + b; \
+		for (unsigned int i = 0; i < j; i++) { \
+			type x = lo[i], y = hi[i]; \
+			lo[i] = x < y ? x: y; \
+			hi[i] = x < y ? y: x; \
+		} \
+	} \
+}
+
+DEFINE_SORT_NETWORK_SCALAR(sort_network_scalar_u32, u32)
+DEFINE_SORT_NETWORK_SCALAR(sort_network_scalar_u64, u64)
+
+#ifdef __AVX2__
+
+/* in-register stage of 8 x 32-bit lanes, j < 8 */
+#define SORT_NETWORK_LANES8(v, r, j, k, min, max, permute, blend) \
+({ \
+	__m256i order = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); \
+	__m256i lane = _mm256_add_epi32(_mm256_set1_epi32((int)(r) * 8), order); \
+	__m256i zero = _mm256_setzero_si256(); \
+	__m256i lo = _mm256_cmpeq_epi32(_mm256_and_si256(lane, \
+	             _mm256_set1_epi32((int)(j))), zero); \
+	__m256i up = _mm256_cmpeq_epi32(_mm256_and_si256(lane, \
+	             _mm256_set1_epi32((int)(k))), zero); \
+	__m256i take = _mm256_cmpeq_epi32(lo, up); \
+	__typeof__(v) p = permute(v, _mm256_xor_si256(order, \
+	                  _mm256_set1_epi32((int)(j)))); \
+	blend(max(v, p), min(v, p), take); \
+})
+
+#define DEFINE_SORT_NETWORK_AVX2_32(name, type, vec, load, store, \
+                                    min, max, permute, blend) \
+static inline void \
+name(type *a, unsigned int size) \
+{ \
+	vec v[SORT_NETWORK_MAX / 8]; \
+	unsigned int regs = size / 8; \
+	for (unsigned int r = 0; r < regs; r++) \
+		v[r] = load(a + r * 8); \
+	for (unsigned int k = 2; k <= size; k <<= 1) \
+	for (unsigned int j = k >> 1; j; j >>= 1) { \
+		if (j < 8) { \
+			for (unsigned int r = 0; r < regs; r++) \
+				v[r] = SORT_NETWORK_LANES8(v[r], r, j, k, min, max, \
+				                           permute, blend); \
+			continue; \
+		} \
+		for (unsigned int r = 0; r < regs; r++) { \
+			unsigned int l = r ^ (j / 8); \
+			if (l < r) \
+				continue; \
+			vec mn = min(v[r], v[l]), mx = max(v[r], v[l]); \
+			int up = !((r * 8) & k); \
+			v[r] = up ? mn: mx; \
+			v[l] = up ? mx: mn; \
+		} \
+	} \
+	for (unsigned int r = 0; r < regs; r++) \
+		store(a + r * 8, v[r]); \
+}
+
+#define SORT_NETWORK_LOADU32(p) _mm256_loadu_si256((const __m256i *)(p))
+#define SORT_NETWORK_STOREU32(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define SORT_NETWORK_BLENDF(a, b, m) _mm256_blendv_ps(a, b, _mm256_castsi256_ps(m))
+
+DEFINE_SORT_NETWORK_AVX2_32(sort_network_avx2_u32, u32, __m256i, 
+                            SORT_NETWORK_LOADU32, SORT_NETWORK_STOREU32,
+                            _mm256_min_epu32, _mm256_max_epu32, 
+                            _mm256_permutevar8x32_epi32, _mm256_blendv_epi8)
+DEFINE_SORT_NETWORK_AVX2_32(sort_network_avx2_float, float, __m256, 
+                            _mm256_loadu_ps, _mm256_storeu_ps,
+                            _mm256_min_ps, _mm256_max_ps,
+                            _mm256_permutevar8x32_ps, SORT_NETWORK_BLENDF)
+
+/* AVX2 has no unsigned 64-bit compare, flip the sign bit and compare signed */
+static inline __m256i
+sort_network_gt_u64(__m256i a, __m256i b)
+{
+	__m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+	return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), 
+	                          _mm256_xor_si256(b, bias));
+}
+
+static inline __m256i
+sort_network_permute_u64(__m256i v, unsigned int j)
+{
+	return j == 1 ? _mm256_permute4x64_epi64(v, 0xb1):
+	                _mm256_permute4x64_epi64(v, 0x4e);
+}
+
+static inline void
+sort_network_avx2_u64(u64 *a, unsigned int size)
+{
+	__m256i v[SORT_NETWORK_MAX / 4];
+	unsigned int regs = size / 4;
+	for (unsigned int r = 0; r < regs; r++)
+		v[r] = _mm256_loadu_si256((const __m256i *)(a + r * 4));
+
+	for (unsigned int k = 2; k <= size; k <<= 1)
+	for (unsigned int j = k >> 1; j; j >>= 1) {
+		if (j < 4) {
+			for (unsigned int r = 0; r < regs; r++) {
+				__m256i lane = _mm256_add_epi64(
+					_mm256_set1_epi64x(r * 4), 
+					_mm256_setr_epi64x(0, 1, 2, 3));
+				__m256i zero = _mm256_setzero_si256();
+				__m256i lo = _mm256_cmpeq_epi64(_mm256_and_si256(lane, 
+				             _mm256_set1_epi64x(j)), zero);
+				__m256i up = _mm256_cmpeq_epi64(_mm256_and_si256(lane, 
+				             _mm256_set1_epi64x(k)), zero);
+				__m256i take = _mm256_cmpeq_epi64(lo, up);
+				__m256i p = sort_network_permute_u64(v[r], j);
+				__m256i gt = sort_network_gt_u64(v[r], p);
+				__m256i mn = _mm256_blendv_epi8(v[r], p, gt);
+				__m256i mx = _mm256_blendv_epi8(p, v[r], gt);
+				v[r] = _mm256_blendv_epi8(mx, mn, take);
+			}
+			continue;
+		}
+		for (unsigned int r = 0; r < regs; r++) {
+			unsigned int l = r ^ (j / 4);
+			if (l < r)
+				continue;
+			__m256i gt = sort_network_gt_u64(v[r], v[l]);
+			__m256i mn = _mm256_blendv_epi8(v[r], v[l], gt);
+			__m256i mx = _mm256_blendv_epi8(v[l], v[r], gt);
+			int up = !((r * 4) & k);
+			v[r] = up ? mn: mx;
+			v[l] = up ? mx: mn;
+		}
+	}
+
+	for (unsigned int r = 0; r < regs; r++)
+		_mm256_storeu_si256((__m256i *)(a + r * 4), v[r]);
+}
+
+#endif/* __AVX2__ */
+
+#ifdef __AVX2__
+#define sort_network_kernel_u32   sort_network_avx2_u32
+#define sort_network_kernel_u64   sort_network_avx2_u64
+#define sort_network_kernel_float sort_network_avx2_float
+#else
+#define sort_network_kernel_u32   sort_network_scalar_u32
+#define sort_network_kernel_u64   sort_network_scalar_u64
+#endif
+
+/* constant sizes let the compiler unroll the network and fold the masks */
+#define SORT_NETWORK_DISPATCH(fn, a, size) \
+({ \
+	switch (size) { \
+	case 4:  fn(a, 4);  break; \
+	case 8:  fn(a, 8);  break; \
+	case 16: fn(a, 16); break; \
+	case 32: fn(a, 32); break; \
+	default: fn(a, 64); break; \
+	} \
+})
+
+void
+sort_network_u32(u32 *array, unsigned int count)
+{
+	u32 a[SORT_NETWORK_MAX];
+	unsigned int size = sort_network_size(count, 8);
+	assert(count <= SORT_NETWORK_MAX);
+	if (count < 2)
+		return;
+
+	memcpy(a, array, count * sizeof(*a));
+	for (unsigned int i = count; i < size; i++)
+		a[i] = UINT32_MAX;
+	SORT_NETWORK_DISPATCH(sort_network_kernel_u32, a, size);
+	memcpy(array, a, count * sizeof(*a));
+}
+
+void
+sort_network_u64(u64 *array, unsigned int count)
+{
+	u64 a[SORT_NETWORK_MAX];
+	unsigned int size = sort_network_size(count, 4);
+	assert(count <= SORT_NETWORK_MAX);
+	if (count < 2)
+		return;
+
+	memcpy(a, array, count * sizeof(*a));
+	for (unsigned int i = count; i < size; i++)
+		a[i] = UINT64_MAX;
+	SORT_NETWORK_DISPATCH(sort_network_kernel_u64, a, size);
+	memcpy(array, a, count * sizeof(*a));
+}
+
+void
+sort_network_float(float *array, unsigned int count)
+{
+	float a[SORT_NETWORK_MAX];
+	unsigned int size = sort_network_size(count, 8);
+	assert(count <= SORT_NETWORK_MAX);
+	if (count < 2)
+		return;
+
+#ifdef __AVX2__
+	memcpy(a, array, count * sizeof(*a));
+	for (unsigned int i = count; i < size; i++)
+		a[i] = __builtin_inff();
+	SORT_NETWORK_DISPATCH(sort_network_kernel_float, a, size);
+	memcpy(array, a, count * sizeof(*a));
+#else
+	/* 
+	 * Scalar float compares do not become branchless min/max, sort the 
+	 * order preserving integer image of the bits instead.
+	 */
+	u32 *x = (u32 *)a, *in = (u32 *)array;
+	for (unsigned int i = 0; i < count; i++)
+		x[i] = in[i] ^ ((u32)-(s32)(in[i] >> 31) | 0x80000000U);
+	for (unsigned int i = count; i < size; i++)
+		x[i] = UINT32_MAX;
+	SORT_NETWORK_DISPATCH(sort_network_kernel_u32, x, size);
+	for (unsigned int i = 0; i < count; i++)
+		in[i] = x[i] ^ (((x[i] >> 31) - 1) | 0x80000000U);
+#endif
+}
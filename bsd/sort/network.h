@@ -0,0 +1,69 @@
+/*
+ * Sorting networks for small arrays
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_NETWORK_H__
+#define __GENERIC_SORT_NETWORK_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/*
+ * Sorting networks
+ *
+ * Batcher's bitonic network over up to SORT_NETWORK_MAX elements. The input
+ * is padded with the largest value to a power of two and kept in vector 
+ * registers, a compare-exchange is a min, a max and a blend. Lanes exchange 
+ * with _mm256_permutevar8x32 (u32, float) or _mm256_permute4x64 (u64) when 
+ * the partner is in the same register and whole registers are paired 
+ * otherwise. Without AVX2 the same network runs on a scalar buffer with 
+ * branchless compare-exchange (floats through their order preserving integer
+ * image), which does not mispredict on random input like insertion sort.
+ *
+ * The networks are also the base case of radix_sort_u32() and 
+ * radix_sort_u64() for small arrays. Floats must not be NaN.
+ *
+ * Time complexity:  Θ(n log^2 n) compare-exchanges, no branches on data
+ * Space complexity: Θ(1)
+ */
+
+#define SORT_NETWORK_MAX 64
+
+/* count must not exceed SORT_NETWORK_MAX */
+void
+sort_network_u32(u32 *array, unsigned int count);
+
+void
+sort_network_u64(u64 *array, unsigned int count);
+
+void
+sort_network_float(float *array, unsigned int count);
+
+__END_DECLS
+
+#endif
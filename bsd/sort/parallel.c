@@ -0,0 +1,343 @@
+/*
+ * Parallel merge sort for intrusive lists
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/list.h>
+#include <bsd/sort.h>
+#include <bsd/sort/parallel.h>
+#include <pthread.h>
+
+#define STRIDE SORT_PARALLEL_STRIDE
+
+struct psort_run {
+	struct node *head, *tail;
+	struct node **idx;    /* node at every STRIDE-th position              */
+	size_t len;
+};
+
+struct psort_job {
+	struct psort_run *a, *b, *out;
+	struct node *a_pos, *a_end, *b_pos, *b_end;
+	struct node *head, *tail;
+	size_t at;            /* position of the first node of the part in out */
+	unsigned int part, parts;
+};
+
+struct psort {
+	pthread_t thread[SORT_PARALLEL_MAX_THREADS];
+	pthread_mutex_t lock;
+	pthread_cond_t wake, idle;
+	void (*fn)(struct psort *, struct psort_job *);
+	int (*cmp)(struct node *, struct node *);
+	struct psort_job job[SORT_PARALLEL_MAX_THREADS];
+	struct psort_run run[2][SORT_PARALLEL_MAX_THREADS];
+	unsigned int workers, jobs, next, busy, gen, quit;
+};
+
+static void
+psort_work(struct psort *ps)
+{
+	unsigned int i;
+	while ((i = __atomic_fetch_add(&ps->next, 1, __ATOMIC_RELAXED)) < ps->jobs)
+		ps->fn(ps, &ps->job[i]);
+}
+
+static void *
+psort_thread(void *arg)
+{
+	struct psort *ps = arg;
+	unsigned int gen = 0;
+	for (;;) {
+		pthread_mutex_lock(&ps->lock);
+		while (ps->gen == gen && !ps->quit)
+			pthread_cond_wait(&ps->wake, &ps->lock);
+		gen = ps->gen;
+		pthread_mutex_unlock(&ps->lock);
+		if (ps->quit)
+			break;
+
+		psort_work(ps);
+
+		pthread_mutex_lock(&ps->lock);
+		if (!--ps->busy)
+			pthread_cond_signal(&ps->idle);
+		pthread_mutex_unlock(&ps->lock);
+	}
+	return NULL;
+}
+
+/* runs @fn over all jobs on the workers and the calling thread */
+static void
+psort_phase(struct psort *ps, void (*fn)(struct psort *, struct psort_job *),
+            unsigned int jobs)
+{
+	pthread_mutex_lock(&ps->lock);
+	ps->fn = fn;
+	ps->jobs = jobs;
+	ps->next = 0;
+	ps->busy = ps->workers;
+	ps->gen++;
+	pthread_cond_broadcast(&ps->wake);
+	pthread_mutex_unlock(&ps->lock);
+
+	psort_work(ps);
+
+	pthread_mutex_lock(&ps->lock);
+	while (ps->busy)
+		pthread_cond_wait(&ps->idle, &ps->lock);
+	pthread_mutex_unlock(&ps->lock);
+}
+
+static void
+psort_segment(struct psort *ps, struct psort_job *job)
+{
+	struct psort_run *run = job->out;
+	struct node *x = slist_sort_natural_asc(job->head, ps->cmp);
+	run->head = x;
+	for (size_t pos = 0; x; x = x->next, pos++) {
+		if (!(pos % STRIDE))
+			run->idx[pos / STRIDE] = x;
+		run->tail = x;
+	}
+}
+
+/*
+ * Finds where part @part of @parts starts. The first run is cut at the 
+ * quantiles of its index, the second one before its first node not less
+ * than the cut node, so equal nodes of the first run stay in front.
+ */
+
+static void
+psort_cut(struct psort *ps, struct psort_job *job, unsigned int part,
+          struct node **a_pos, struct node **b_pos, size_t *at)
+{
+	struct psort_run *a = job->a, *b = job->b;
+	size_t na = (a->len + STRIDE - 1) / STRIDE;
+	size_t nb = (b->len + STRIDE - 1) / STRIDE;
+	size_t p = (size_t)part * na / job->parts, lo = 0, hi = nb;
+
+	if (part == job->parts) {
+		*a_pos = *b_pos = NULL;
+		*at = a->len + b->len;
+		return;
+	}
+	if (!p) {
+		*a_pos = a->head;
+		*b_pos = b->head;
+		*at = 0;
+		return;
+	}
+
+	struct node *key = a->idx[p], *x;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (ps->cmp(b->idx[mid], key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*a_pos = key;
+	*at = p * STRIDE;
+	if (!lo) {
+		*b_pos = b->head;
+		return;
+	}
+
+	size_t pos = (lo - 1) * STRIDE;
+	for (x = b->idx[lo - 1]; x && ps->cmp(x, key) < 0; x = x->next)
+		pos++;
+	*b_pos = x;
+	*at += pos;
+}
+
+static void
+psort_split(struct psort *ps, struct psort_job *job)
+{
+	size_t end;
+	psort_cut(ps, job, job->part, &job->a_pos, &job->b_pos, &job->at);
+	psort_cut(ps, job, job->part + 1, &job->a_end, &job->b_end, &end);
+}
+
+#define psort_append(t, x, idx, at) \
+({ \
+	(t)->next = (x); (x)->prev = (t); (t) = (x); \
+	if (!((at) % STRIDE)) \
+		(idx)[(at) / STRIDE] = (x); \
+	(at)++; \
+})
+
+static void
+psort_merge(struct psort *ps, struct psort_job *job)
+{
+	struct node *a = job->a_pos, *b = job->b_pos, *x, head, *t = &head;
+	struct node **idx = job->out->idx;
+	size_t at = job->at;
+
+	while (a != job->a_end && b != job->b_end) {
+		if (ps->cmp(b, a) < 0)
+			x = b, b = b->next;
+		else
+			x = a, a = a->next;
+		psort_append(t, x, idx, at);
+	}
+	for (; a != job->a_end; a = x->next) {
+		x = a;
+		psort_append(t, x, idx, at);
+	}
+	for (; b != job->b_end; b = x->next) {
+		x = b;
+		psort_append(t, x, idx, at);
+	}
+
+	job->head = t == &head ? NULL: head.next;
+	job->tail = t;
+}
+
+static struct node **
+psort_idx(struct mm *mm, size_t len)
+{
+	return mm_alloc(mm, ((len + STRIDE - 1) / STRIDE) * sizeof(struct node *));
+}
+
+/* cuts the list into @parts segments and sorts them */
+static unsigned int
+psort_segments(struct psort *ps, struct list *list, size_t count,
+               unsigned int parts, struct mm *mm)
+{
+	struct node *x = list_disable_prev(list);
+	for (unsigned int i = 0; i < parts; i++) {
+		struct psort_run *run = &ps->run[0][i];
+		run->len = count / parts + (i < count % parts);
+		run->idx = psort_idx(mm, run->len);
+		ps->job[i].out = run;
+		ps->job[i].head = x;
+		for (size_t k = 1; k < run->len; k++)
+			x = x->next;
+		struct node *y = x->next;
+		x->next = NULL;
+		x = y;
+	}
+
+	psort_phase(ps, psort_segment, parts);
+	return parts;
+}
+
+static unsigned int
+psort_level(struct psort *ps, struct psort_run *in, struct psort_run *out,
+            unsigned int runs, unsigned int threads, struct mm *mm)
+{
+	unsigned int pairs = runs / 2, parts = __max(threads / pairs, 1U), jobs = 0;
+
+	for (unsigned int i = 0; i < pairs; i++) {
+		out[i].len = in[2 * i].len + in[2 * i + 1].len;
+		out[i].idx = psort_idx(mm, out[i].len);
+		for (unsigned int part = 0; part < parts; part++, jobs++) {
+			struct psort_job *job = &ps->job[jobs];
+			job->a = &in[2 * i];
+			job->b = &in[2 * i + 1];
+			job->out = &out[i];
+			job->part = part;
+			job->parts = parts;
+		}
+	}
+
+	psort_phase(ps, psort_split, jobs);
+	psort_phase(ps, psort_merge, jobs);
+
+	for (unsigned int i = 0; i < pairs; i++) {
+		struct node *tail = NULL;
+		out[i].head = NULL;
+		for (unsigned int part = 0; part < parts; part++) {
+			struct psort_job *job = &ps->job[i * parts + part];
+			if (!job->head)
+				continue;
+			if (tail)
+				tail->next = job->head, job->head->prev = tail;
+			else
+				out[i].head = job->head;
+			tail = job->tail;
+		}
+		tail->next = NULL;
+		out[i].tail = tail;
+		mm_free(mm, in[2 * i].idx);
+		mm_free(mm, in[2 * i + 1].idx);
+	}
+
+	if (runs & 1)
+		out[pairs] = in[runs - 1];
+	return pairs + (runs & 1);
+}
+
+void
+merge_sort_parallel(struct list *list, int (*cmp)(struct node *, struct node *),
+                    unsigned int threads, struct mm *mm)
+{
+	size_t count = list_size(list);
+	threads = __min(threads, SORT_PARALLEL_MAX_THREADS);
+	threads = __min(threads, count / SORT_PARALLEL_MIN);
+	if (threads < 2) {
+		merge_sort_natural_asc(list, list, cmp);
+		return;
+	}
+
+	struct psort *ps = mm_zalloc(mm, sizeof(*ps));
+	ps->cmp = cmp;
+	pthread_mutex_init(&ps->lock, NULL);
+	pthread_cond_init(&ps->wake, NULL);
+	pthread_cond_init(&ps->idle, NULL);
+	for (; ps->workers < threads - 1; ps->workers++)
+		if (pthread_create(&ps->thread[ps->workers], NULL, psort_thread, ps))
+			break;
+
+	unsigned int runs = psort_segments(ps, list, count, threads, mm), cur = 0;
+	for (; runs > 1; cur ^= 1)
+		runs = psort_level(ps, ps->run[cur], ps->run[cur ^ 1], runs, 
+		                   threads, mm);
+
+	struct psort_run *run = &ps->run[cur][0];
+	list->head.next = run->head;
+	list->head.prev = run->tail;
+	run->head->prev = &list->head;
+	run->tail->next = &list->head;
+	mm_free(mm, run->idx);
+
+	pthread_mutex_lock(&ps->lock);
+	ps->quit = 1;
+	pthread_cond_broadcast(&ps->wake);
+	pthread_mutex_unlock(&ps->lock);
+	for (unsigned int i = 0; i < ps->workers; i++)
+		pthread_join(ps->thread[i], NULL);
+
+	pthread_cond_destroy(&ps->idle);
+	pthread_cond_destroy(&ps->wake);
+	pthread_mutex_destroy(&ps->lock);
+	mm_free(mm, ps);
+}
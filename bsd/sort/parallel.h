@@ -0,0 +1,79 @@
+/*
+ * Parallel merge sort for intrusive lists
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_PARALLEL_H__
+#define __GENERIC_SORT_PARALLEL_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Parallel merge sort
+ *
+ * The list is cut into one segment per thread and every segment is sorted 
+ * with slist_sort_natural_asc(). Sorted runs are then merged pairwise level 
+ * by level. While there are fewer pairs than threads, a merge is split into 
+ * parts: every SORT_PARALLEL_STRIDE-th node of a run is kept in a sparse 
+ * index, the parts are cut at quantiles of the first run and the matching 
+ * nodes of the second run are found by binary search over its index. All 
+ * threads take part in the last merge this way, and the prev links are 
+ * restored while merging.
+ *
+ * Threads are started once per sort and wait on a barrier between phases. 
+ * Lists shorter than SORT_PARALLEL_MIN nodes per thread are sorted on the 
+ * calling thread. Stable.
+ *
+ * Time complexity:  O((n log n) / threads + n)
+ * Space complexity: O(n / SORT_PARALLEL_STRIDE)
+ */
+
+#define SORT_PARALLEL_MAX_THREADS 64
+#define SORT_PARALLEL_STRIDE      256
+#define SORT_PARALLEL_MIN         16384
+
+/**
+ * merge_sort_parallel - sort a list using several threads
+ *
+ * @list:       the list
+ * @cmp:        compares two nodes like strcmp()
+ * @threads:    number of threads including the caller
+ * @mm:         memory for the run indices
+ */
+
+void
+merge_sort_parallel(struct list *list, int (*cmp)(struct node *, struct node *),
+                    unsigned int threads, struct mm *mm);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * Pattern-defeating quicksort for arrays
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_PDQ_H__
+#define __GENERIC_SORT_PDQ_H__
+
+#include <stddef.h>
+
+/*
+ * Pattern-defeating quicksort
+ *
+ * Orson Peters: Pattern-defeating Quicksort, https://arxiv.org/abs/2106.05123
+ * Edelkamp, Weiss: BlockQuicksort: How Branch Mispredictions don't affect 
+ * Quicksort
+ *
+ * Array sort specialized for the element type and the comparison at compile 
+ * time, so unlike qsort() there are no indirect calls and no memcpy() of 
+ * opaque elements. Introsort with median of 3 (ninther above 128 elements),
+ * insertion sort below 24 elements, partitioning which records misplaced 
+ * elements in offset blocks instead of branching on every comparison, and 
+ * pattern detection: already partitioned ranges are finished by a bounded 
+ * insertion sort, runs of equal keys are split off by partition_left, and 
+ * bad pivots shuffle the range and eventually fall back to heapsort, so the 
+ * worst case stays O(n log n). The sort is not stable.
+ *
+ * C:
+ *   #define int_less(a, b) ((a) < (b))
+ *   DEFINE_PDQ_SORT(int_sort, int, int_less)
+ *   int_sort(array, count);
+ *
+ * C++:
+ *   pdq_sort(array, count);
+ *   pdq_sort(array, count, [](const T &a, const T &b) { ... });
+ *
+ * The header does not depend on <sys/compiler.h> so that it can be used from
+ * C++ sources.
+ *
+ * Time complexity:  O(n log n), O(n) on sorted and reverse sorted input
+ * Space complexity: O(log n)
+ */
+
+#define PDQ_INSERT        24
+#define PDQ_NINTHER       128
+#define PDQ_PARTIAL_LIMIT 8
+#define PDQ_BLOCK         64
+
+#define __DEFINE_PDQ_SORT(storage, name, type, less) \
+storage void \
+name##_swap(type *a, type *b) \
+{ \
+	type t = *a; *a = *b; *b = t; \
+} \
+storage void \
+name##_sort2(type *a, type *b) \
+{ \
+	if (less(*b, *a)) \
+		name##_swap(a, b); \
+} \
+storage void \
+name##_sort3(type *a, type *b, type *c) \
+{ \
+	name##_sort2(a, b); \
+	name##_sort2(b, c); \
+	name##_sort2(a, b); \
+} \
+storage void \
+name##_insert(type *begin, type *end) \
+{ \
+	if (begin == end) \
+		return; \
+	for (type *cur = begin + 1; cur != end; cur++) { \
+		type *sift = cur, *sift_1 = cur - 1; \
+		if (!less(*sift, *sift_1)) \
+			continue; \
+		type tmp = *sift; \
+		do { *sift-- = *sift_1; } \
+		while (sift != begin && less(tmp, *--sift_1)); \
+		*sift = tmp; \
+	} \
+} \
+/* begin[-1] is known to be <= than every element */ \
+storage void \
+name##_insert_unguarded(type *begin, type *end) \
+{ \
+	if (begin == end) \
+		return; \
+	for (type *cur = begin + 1; cur != end; cur++) { \
+		type *sift = cur, *sift_1 = cur - 1; \
+		if (!less(*sift, *sift_1)) \
+			continue; \
+		type tmp = *sift; \
+		do { *sift-- = *sift_1; } \
+		while (less(tmp, *--sift_1)); \
+		*sift = tmp; \
+	} \
+} \
+/* gives up after PDQ_PARTIAL_LIMIT moves, returns non-zero when sorted */ \
+storage int \
+name##_insert_partial(type *begin, type *end) \
+{ \
+	size_t limit = 0; \
+	if (begin == end) \
+		return 1; \
+	for (type *cur = begin + 1; cur != end; cur++) { \
+		type *sift = cur, *sift_1 = cur - 1; \
+		if (less(*sift, *sift_1)) { \
+			type tmp = *sift; \
+			do { *sift-- = *sift_1; } \
+			while (sift != begin && less(tmp, *--sift_1)); \
+			*sift = tmp; \
+			limit += (size_t)(cur - sift); \
+		} \
+		if (limit > PDQ_PARTIAL_LIMIT) \
+			return 0; \
+	} \
+	return 1; \
+} \
+storage void \
+name##_sift(type *a, size_t root, size_t count) \
+{ \
+	type tmp = a[root]; \
+	for (size_t child; (child = 2 * root + 1) < count; root = child) { \
+		if (child + 1 < count && less(a[child], a[child + 1])) \
+			child++; \
+		if (!less(tmp, a[child])) \
+			break; \
+		a[root] = a[child]; \
+	} \
+	a[root] = tmp; \
+} \
+storage void \
+name##_heap(type *begin, type *end) \
+{ \
+	size_t count = (size_t)(end - begin); \
+	for (size_t i = count / 2; i-- > 0; ) \
+		name##_sift(begin, i, count); \
+	while (count > 1) { \
+		name##_swap(begin, begin + --count); \
+		name##_sift(begin, 0, count); \
+	} \
+} \
+storage void \
+name##_swap_offsets(type *first, type *last, unsigned char *offsets_l, \
+                    unsigned char *offsets_r, size_t num, int use_swaps) \
+{ \
+	if (use_swaps) { \
+		for (size_t i = 0; i < num; i++) \
+			name##_swap(first + offsets_l[i], last - offsets_r[i]); \
+	} else if (num > 0) { \
+		type *l = first + offsets_l[0], *r = last - offsets_r[0]; \
+		type tmp = *l; *l = *r; \
+		for (size_t i = 1; i < num; i++) { \
+			l = first + offsets_l[i]; *r = *l; \
+			r = last - offsets_r[i]; *l = *r; \
+		} \
+		*r = tmp; \
+	} \
+} \
+/* elements equal to the pivot go right, returns pivot position */ \
+storage type * \
+name##_partition_right(type *begin, type *end, int *partitioned) \
+{ \
+	type pivot = *begin, *first = begin, *last = end; \
+	while (less(*++first, pivot)); \
+	if (first - 1 == begin) \
+		while (first < last && !less(*--last, pivot)); \
+	else \
+		while (!less(*--last, pivot)); \
+	*partitioned = first >= last; \
+	if (!*partitioned) { \
+		unsigned char offsets_l[PDQ_BLOCK], offsets_r[PDQ_BLOCK]; \
+		type *offsets_l_base, *offsets_r_base; \
+		size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0; \
+		name##_swap(first, last); \
+		first++; \
+		offsets_l_base = first; \
+		offsets_r_base = last; \
+		while (first < last) { \
+			size_t unknown = (size_t)(last - first); \
+			size_t left = num_l ? 0: (num_r ? unknown: unknown / 2); \
+			size_t right = num_r ? 0: unknown - left; \
+			size_t n = left < PDQ_BLOCK ? left: PDQ_BLOCK; \
+			for (size_t i = 0; i < n; ) { \
+				offsets_l[num_l] = (unsigned char)i++; \
+				num_l += !less(*first, pivot); first++; \
+			} \
+			n = right < PDQ_BLOCK ? right: PDQ_BLOCK; \
+			for (size_t i = 0; i < n; ) { \
+				offsets_r[num_r] = (unsigned char)++i; \
+				num_r += less(*--last, pivot); \
+			} \
+			size_t num = num_l < num_r ? num_l: num_r; \
+			name##_swap_offsets(offsets_l_base, offsets_r_base, \
+			                    offsets_l + start_l, offsets_r + start_r, \
+			                    num, num_l == num_r); \
+			num_l -= num; num_r -= num; \
+			start_l += num; start_r += num; \
+			if (!num_l) { \
+				start_l = 0; \
+				offsets_l_base = first; \
+			} \
+			if (!num_r) { \
+				start_r = 0; \
+				offsets_r_base = last; \
+			} \
+		} \
+		if (num_l) { \
+			while (num_l--) \
+				name##_swap(offsets_l_base + offsets_l[start_l + num_l], --last); \
+			first = last; \
+		} \
+		if (num_r) { \
+			while (num_r--) \
+				name##_swap(offsets_r_base - offsets_r[start_r + num_r], first++); \
+			last = first; \
+		} \
+	} \
+	type *pivot_pos = first - 1; \
+	*begin = *pivot_pos; \
+	*pivot_pos = pivot; \
+	return pivot_pos; \
+} \
+/* elements equal to the pivot go left, used for runs of equal keys */ \
+storage type * \
+name##_partition_left(type *begin, type *end) \
+{ \
+	type pivot = *begin, *first = begin, *last = end; \
+	while (less(pivot, *--last)); \
+	if (last + 1 == end) \
+		while (first < last && !less(pivot, *++first)); \
+	else \
+		while (!less(pivot, *++first)); \
+	while (first < last) { \
+		name##_swap(first, last); \
+		while (less(pivot, *--last)); \
+		while (!less(pivot, *++first)); \
+	} \
+	*begin = *last; \
+	*last = pivot; \
+	return last; \
+} \
+storage void \
+name##_loop(type *begin, type *end, int bad, int leftmost) \
+{ \
+	for (;;) { \
+		size_t size = (size_t)(end - begin), s2 = size / 2; \
+		if (size < PDQ_INSERT) { \
+			if (leftmost) \
+				name##_insert(begin, end); \
+			else \
+				name##_insert_unguarded(begin, end); \
+			return; \
+		} \
+		if (size > PDQ_NINTHER) { \
+			name##_sort3(begin, begin + s2, end - 1); \
+			name##_sort3(begin + 1, begin + (s2 - 1), end - 2); \
+			name##_sort3(begin + 2, begin + (s2 + 1), end - 3); \
+			name##_sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1)); \
+			name##_swap(begin, begin + s2); \
+		} else { \
+			name##_sort3(begin + s2, begin, end - 1); \
+		} \
+		if (!leftmost && !less(*(begin - 1), *begin)) { \
+			begin = name##_partition_left(begin, end) + 1; \
+			continue; \
+		} \
+		int partitioned; \
+		type *pivot = name##_partition_right(begin, end, &partitioned); \
+		size_t l_size = (size_t)(pivot - begin); \
+		size_t r_size = (size_t)(end - (pivot + 1)); \
+		if (l_size < size / 8 || r_size < size / 8) { \
+			if (--bad == 0) { \
+				name##_heap(begin, end); \
+				return; \
+			} \
+			if (l_size >= PDQ_INSERT) { \
+				name##_swap(begin, begin + l_size / 4); \
+				name##_swap(pivot - 1, pivot - l_size / 4); \
+				if (l_size > PDQ_NINTHER) { \
+					name##_swap(begin + 1, begin + (l_size / 4 + 1)); \
+					name##_swap(begin + 2, begin + (l_size / 4 + 2)); \
+					name##_swap(pivot - 2, pivot - (l_size / 4 + 1)); \
+					name##_swap(pivot - 3, pivot - (l_size / 4 + 2)); \
+				} \
+			} \
+			if (r_size >= PDQ_INSERT) { \
+				name##_swap(pivot + 1, pivot + (1 + r_size / 4)); \
+				name##_swap(end - 1, end - r_size / 4); \
+				if (r_size > PDQ_NINTHER) { \
+					name##_swap(pivot + 2, pivot + (2 + r_size / 4)); \
+					name##_swap(pivot + 3, pivot + (3 + r_size / 4)); \
+					name##_swap(end - 2, end - (1 + r_size / 4)); \
+					name##_swap(end - 3, end - (2 + r_size / 4)); \
+				} \
+			} \
+		} else if (partitioned &&  \
+		           name##_insert_partial(begin, pivot) && \
+		           name##_insert_partial(pivot + 1, end)) { \
+			return; \
+		} \
+		name##_loop(begin, pivot, bad, leftmost); \
+		begin = pivot + 1; \
+		leftmost = 0; \
+	} \
+} \
+storage void \
+name(type *array, size_t count) \
+{ \
+	int bad = 1; \
+	for (size_t n = count; n > 1; n >>= 1) \
+		bad++; \
+	if (count > 1) \
+		name##_loop(array, array + count, bad, 1); \
+}
+
+/**
+ * DEFINE_PDQ_SORT - define sort function for arrays
+ *
+ * @name:       the function, void name(type *array, size_t count)
+ * @type:       element type
+ * @less:       less(a, b) non-zero when a sorts before b, macro or function
+ *
+ * Helpers are defined as name_xxx() static functions.
+ */
+
+#define DEFINE_PDQ_SORT(name, type, less) \
+	__DEFINE_PDQ_SORT(static __attribute__((unused)), name, type, less)
+
+#ifdef __cplusplus
+
+#include <functional>
+
+template <typename T, typename Less>
+struct pdq_sorter {
+	Less less;
+	__DEFINE_PDQ_SORT(, sort, T, less)
+};
+
+template <typename T, typename Less = std::less<T>>
+inline void
+pdq_sort(T *array, size_t count, Less less = Less())
+{
+	pdq_sorter<T, Less> { less }.sort(array, count);
+}
+
+#endif/* __cplusplus */
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ * Radix sort for integer, float and fixed-width keys
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/sort/radix.h>
+#include <bsd/sort/network.h>
+#include <string.h>
+
+#define RADIX_MSD_CUTOFF 32
+
+/*
+ * Turns per-digit histograms into bucket offsets and tells which digits 
+ * have to be sorted at all.
+ */
+
+static unsigned int
+radix_plan(size_t (*hist)[RADIX_SIZE], unsigned int digits, size_t count,
+           unsigned int *pass)
+{
+	unsigned int passes = 0;
+	for (unsigned int d = 0; d < digits; d++) {
+		size_t sum = 0, *h = hist[d];
+		int trivial = 0;
+		for (unsigned int i = 0; i < RADIX_SIZE; i++) {
+			if (h[i] == count)
+				trivial = 1;
+			size_t c = h[i];
+			h[i] = sum;
+			sum += c;
+		}
+		if (!trivial)
+			pass[passes++] = d;
+	}
+	return passes;
+}
+
+#define DEFINE_RADIX_SORT(name, type) \
+static void \
+name(type *array, size_t count, struct mm *mm) \
+{ \
+	enum { digits = sizeof(type) }; \
+	size_t hist[digits][RADIX_SIZE]; \
+	unsigned int pass[digits]; \
+	memset(hist, 0, sizeof(hist)); \
+	for (size_t i = 0; i < count; i++) { \
+		type x = array[i]; \
+		for (unsigned int d = 0; d < digits; d++) \
+			hist[d][(x >> (d * RADIX_BITS)) & (RADIX_SIZE - 1)]++; \
+	} \
+	unsigned int passes = radix_plan(hist, digits, count, pass); \
+	if (!passes) \
+		return; \
+	type *src = array, *dst = mm_alloc(mm, count * sizeof(type)), *tmp; \
+	type *scratch = dst; \
+	for (unsigned int p = 0; p < passes; p++) { \
+		unsigned int shift = pass[p] * RADIX_BITS; \
+		size_t *h = hist[pass[p]]; \
+		for (size_t i = 0; i < count; i++) { \
+			type x = src[i]; \
+			dst[h[(x >> shift) & (RADIX_SIZE - 1)]++] = x; \
+		} \
+		tmp = src; src = dst; dst = tmp; \
+	} \
+	if (src != array) \
+		memcpy(array, src, count * sizeof(type)); \
+	mm_free(mm, scratch); \
+}
+
+DEFINE_RADIX_SORT(radix_lsd_u32, u32)
+DEFINE_RADIX_SORT(radix_lsd_u64, u64)
+
+void
+radix_sort_u32(u32 *array, size_t count, struct mm *mm)
+{
+	if (count <= SORT_NETWORK_MAX)
+		sort_network_u32(array, (unsigned int)count);
+	else
+		radix_lsd_u32(array, count, mm);
+}
+
+void
+radix_sort_u64(u64 *array, size_t count, struct mm *mm)
+{
+	if (count <= SORT_NETWORK_MAX)
+		sort_network_u64(array, (unsigned int)count);
+	else
+		radix_lsd_u64(array, count, mm);
+}
+
+/* order preserving mapping of IEEE-754 bits to unsigned integers */
+static inline u32
+radix_float_key(u32 x)
+{
+	return x ^ ((u32)-(s32)(x >> 31) | 0x80000000U);
+}
+
+static inline u32
+radix_float_unkey(u32 x)
+{
+	return x ^ (((x >> 31) - 1) | 0x80000000U);
+}
+
+static inline u64
+radix_double_key(u64 x)
+{
+	return x ^ ((u64)-(s64)(x >> 63) | 0x8000000000000000ULL);
+}
+
+static inline u64
+radix_double_unkey(u64 x)
+{
+	return x ^ (((x >> 63) - 1) | 0x8000000000000000ULL);
+}
+
+void
+radix_sort_float(float *array, size_t count, struct mm *mm)
+{
+	u32 *a = (u32 *)array;
+	for (size_t i = 0; i < count; i++)
+		a[i] = radix_float_key(a[i]);
+	radix_lsd_u32(a, count, mm);
+	for (size_t i = 0; i < count; i++)
+		a[i] = radix_float_unkey(a[i]);
+}
+
+void
+radix_sort_double(double *array, size_t count, struct mm *mm)
+{
+	u64 *a = (u64 *)array;
+	for (size_t i = 0; i < count; i++)
+		a[i] = radix_double_key(a[i]);
+	radix_lsd_u64(a, count, mm);
+	for (size_t i = 0; i < count; i++)
+		a[i] = radix_double_unkey(a[i]);
+}
+
+static inline u64
+radix_rec_key(const u8 *rec, size_t offset, unsigned int bytes)
+{
+	u64 key = 0;
+	memcpy(&key, rec + offset, bytes);
+	return key;
+}
+
+void
+radix_sort_rec(void *base, size_t count, size_t size, size_t offset, 
+               unsigned int bytes, struct mm *mm)
+{
+	size_t hist[8][RADIX_SIZE];
+	unsigned int pass[8];
+
+	bytes = __min(__max(bytes, 1), 8);
+	memset(hist, 0, sizeof(hist));
+	for (size_t i = 0; i < count; i++) {
+		u64 x = radix_rec_key((u8 *)base + i * size, offset, bytes);
+		for (unsigned int d = 0; d < bytes; d++)
+			hist[d][(x >> (d * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+	}
+
+	unsigned int passes = radix_plan(hist, bytes, count, pass);
+	if (!passes)
+		return;
+
+	u8 *src = base, *dst = mm_alloc(mm, count * size), *tmp;
+	u8 *scratch = dst;
+	for (unsigned int p = 0; p < passes; p++) {
+		unsigned int shift = pass[p] * RADIX_BITS;
+		size_t *h = hist[pass[p]];
+		for (size_t i = 0; i < count; i++) {
+			const u8 *rec = src + i * size;
+			u64 x = radix_rec_key(rec, offset, bytes);
+			size_t at = h[(x >> shift) & (RADIX_SIZE - 1)]++;
+			memcpy(dst + at * size, rec, size);
+		}
+		tmp = src; src = dst; dst = tmp;
+	}
+
+	if (src != base)
+		memcpy(base, src, count * size);
+	mm_free(mm, scratch);
+}
+
+/* range of records which share the first @depth key bytes */
+struct radix_msd_part {
+	u8 *base;
+	size_t count;
+	size_t depth;
+};
+
+struct radix_msd {
+	u8 *scratch;
+	struct radix_msd_part *stack;
+	size_t size;
+	size_t offset;
+	size_t bytes;
+};
+
+static void
+radix_msd_insert(struct radix_msd *msd, u8 *base, size_t count, size_t depth)
+{
+	size_t size = msd->size, len = msd->bytes - depth;
+	u8 *tmp = msd->scratch;
+	for (size_t i = 1; i < count; i++) {
+		u8 *x = base + i * size;
+		const u8 *key = x + msd->offset + depth;
+		size_t j = i;
+		while (j && memcmp(base + (j - 1) * size + msd->offset + depth, 
+		                   key, len) > 0)
+			j--;
+		if (j == i)
+			continue;
+		memcpy(tmp, x, size);
+		memmove(base + (j + 1) * size, base + j * size, (i - j) * size);
+		memcpy(base + j * size, tmp, size);
+	}
+}
+
+/*
+ * Splits @part by its first byte which differs and pushes the buckets on 
+ * @stack, the largest first so that it is taken last. Every other bucket 
+ * has at most half of the records, so each level of the stack holds parts 
+ * at most half the size of the level below and the stack needs no more 
+ * than RADIX_SIZE entries per bit of the record count, whatever the key 
+ * length. Returns the number of parts pushed.
+ */
+
+static size_t
+radix_msd_split(struct radix_msd *msd, const struct radix_msd_part *part, 
+                struct radix_msd_part *stack)
+{
+	size_t size = msd->size, pos[RADIX_SIZE], hist[RADIX_SIZE];
+	size_t count = part->count, depth = part->depth;
+	u8 *base = part->base;
+
+	/* skip bytes shared by all keys */
+	for (; depth < msd->bytes; depth++) {
+		if (count < RADIX_MSD_CUTOFF) {
+			radix_msd_insert(msd, base, count, depth);
+			return 0;
+		}
+
+		memset(hist, 0, sizeof(hist));
+		for (size_t i = 0; i < count; i++)
+			hist[base[i * size + msd->offset + depth]]++;
+
+		size_t sum = 0;
+		int trivial = 0;
+		for (unsigned int i = 0; i < RADIX_SIZE; i++) {
+			trivial |= hist[i] == count;
+			pos[i] = sum;
+			sum += hist[i];
+		}
+		if (!trivial)
+			break;
+	}
+
+	if (depth >= msd->bytes)
+		return 0;
+
+	u8 *dst = msd->scratch;
+	unsigned int largest = 0;
+	for (size_t i = 0; i < count; i++) {
+		const u8 *rec = base + i * size;
+		memcpy(dst + pos[rec[msd->offset + depth]]++ * size, rec, size);
+	}
+	memcpy(base, dst, count * size);
+
+	for (unsigned int i = 1; i < RADIX_SIZE; i++)
+		if (hist[i] > hist[largest])
+			largest = i;
+
+	size_t n = 0;
+	stack[n++] = (struct radix_msd_part) {
+		.base = base + (pos[largest] - hist[largest]) * size,
+		.count = hist[largest], .depth = depth + 1,
+	};
+	for (unsigned int i = 0; i < RADIX_SIZE; i++) {
+		if (i == largest || hist[i] < 2)
+			continue;
+		stack[n++] = (struct radix_msd_part) {
+			.base = base + (pos[i] - hist[i]) * size,
+			.count = hist[i], .depth = depth + 1,
+		};
+	}
+	return n;
+}
+
+/* parts on the stack for @count records, see radix_msd_split() */
+static size_t
+radix_msd_stack(size_t count)
+{
+	size_t bits = 1;
+	while (count >>= 1)
+		bits++;
+	return RADIX_SIZE * bits;
+}
+
+void
+radix_sort_msd(void *base, size_t count, size_t size, size_t offset,
+               size_t bytes, struct mm *mm)
+{
+	if (count < 2 || !bytes)
+		return;
+
+	struct radix_msd msd = {
+		.scratch = mm_alloc(mm, count * size),
+		.stack = mm_alloc(mm, radix_msd_stack(count) * 
+		                  sizeof(struct radix_msd_part)),
+		.size = size, .offset = offset, .bytes = bytes
+	};
+
+	size_t n = 0;
+	msd.stack[n++] = (struct radix_msd_part) { base, count, 0 };
+	while (n) {
+		struct radix_msd_part part = msd.stack[--n];
+		n += radix_msd_split(&msd, &part, msd.stack + n);
+	}
+
+	mm_free(mm, msd.stack);
+	mm_free(mm, msd.scratch);
+}
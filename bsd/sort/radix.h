@@ -0,0 +1,109 @@
+/*
+ * Radix sort for integer, float and fixed-width keys
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_RADIX_H__
+#define __GENERIC_SORT_RADIX_H__
+
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+
+__BEGIN_DECLS
+
+/* opaque info for memory allocation */
+struct mm;
+
+/*
+ * Radix sort
+ *
+ * LSD radix sort with 8-bit digits for arrays of keys and of records 
+ * carrying a key. The histograms of all digits are built in a single read of
+ * the input and digits where every key falls into the same bucket are 
+ * skipped, so sorting u64 keys which differ only in the low 32 bits costs
+ * four passes instead of eight. All sorts are stable and need a scratch copy
+ * of the array, taken from @mm. Arrays of up to SORT_NETWORK_MAX u32 or u64 
+ * keys go to the sorting networks instead.
+ *
+ * Floats are sorted by their IEEE-754 bits with the sign folded in, which 
+ * gives -inf < ... < -0.0 < 0.0 < ... < inf, NaNs go to the ends by sign.
+ *
+ * radix_sort_msd() sorts records by a long byte-string key in memcmp() 
+ * order, most significant byte first. It only looks at as many bytes as 
+ * needed to tell the keys apart, which wins over LSD for long keys with 
+ * distinct prefixes.
+ *
+ * Time complexity:  Θ(n * key bytes)
+ * Space complexity: Θ(n)
+ */
+
+#define RADIX_BITS  8
+#define RADIX_SIZE  (1 << RADIX_BITS)
+
+void
+radix_sort_u32(u32 *array, size_t count, struct mm *mm);
+
+void
+radix_sort_u64(u64 *array, size_t count, struct mm *mm);
+
+void
+radix_sort_float(float *array, size_t count, struct mm *mm);
+
+void
+radix_sort_double(double *array, size_t count, struct mm *mm);
+
+/**
+ * radix_sort_rec - sort records by unsigned integer key
+ *
+ * @base:       the records
+ * @count:      number of records
+ * @size:       record size
+ * @offset:     offset of the key in the record
+ * @bytes:      key size, 1 to 8 bytes, native little-endian
+ * @mm:         memory context for the scratch copy
+ */
+
+void
+radix_sort_rec(void *base, size_t count, size_t size, size_t offset, 
+               unsigned int bytes, struct mm *mm);
+
+/**
+ * radix_sort_msd - sort records by byte-string key
+ *
+ * @base:       the records
+ * @count:      number of records
+ * @size:       record size
+ * @offset:     offset of the key in the record
+ * @bytes:      key length, compared as memcmp()
+ * @mm:         memory context for the scratch copy
+ */
+
+void
+radix_sort_msd(void *base, size_t count, size_t size, size_t offset,
+               size_t bytes, struct mm *mm);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Selection, partial sort and bounded top-k for arrays
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#ifndef __GENERIC_SORT_SELECT_H__
+#define __GENERIC_SORT_SELECT_H__
+
+#include <stddef.h>
+
+/*
+ * Selection
+ *
+ * name_nth(array, count, k) rearranges the array so that array[k] holds the 
+ * element which would be there if the array was sorted, no element before 
+ * it is greater and no element after it is less (nth_element). Quickselect 
+ * with median of 3 pivots (ninther above SELECT_NINTHER elements) and Hoare 
+ * partitioning which stops on equal keys, so runs of duplicates split in 
+ * the middle. After 2 log2(n) rounds without progress it falls back to heap
+ * selection, the worst case stays O(n log n).
+ *
+ * name_partial(array, count, k) moves the k least elements to the front in
+ * sorted order, the rest is left in unspecified order.
+ *
+ * name_topk_push(heap, &len, k, item) keeps the k least items of a stream 
+ * in a bounded max-heap, which costs one compare for an item not less than
+ * the k-th one seen so far. name_topk_sort(heap, len) sorts the result.
+ *
+ *   #define int_less(a, b) ((a) < (b))
+ *   DEFINE_SELECT(int_select, int, int_less)
+ *   int_select_partial(array, count, 100);
+ *
+ * Nothing here is stable. Intrusive lists use top_k_asc() and 
+ * partial_sort_asc() from <bsd/sort.h>.
+ *
+ * Time complexity:  Θ(n) average for nth, O(n + k log k) for partial,
+ *                   O(n log k) for topk
+ * Space complexity: O(1)
+ */
+
+#define SELECT_INSERT  16
+#define SELECT_NINTHER 128
+
+#define __DEFINE_SELECT(storage, name, type, less) \
+storage void \
+name##_swap(type *a, type *b) \
+{ \
+	type t = *a; *a = *b; *b = t; \
+} \
+storage void \
+name##_insert(type *a, size_t count) \
+{ \
+	for (size_t i = 1; i < count; i++) { \
+		type t = a[i]; \
+		size_t j = i; \
+		for (; j && less(t, a[j - 1]); j--) \
+			a[j] = a[j - 1]; \
+		a[j] = t; \
+	} \
+} \
+storage void \
+name##_sift(type *a, size_t count, size_t i) \
+{ \
+	type t = a[i]; \
+	for (size_t c; (c = 2 * i + 1) < count; i = c) { \
+		if (c + 1 < count && less(a[c], a[c + 1])) \
+			c++; \
+		if (!less(t, a[c])) \
+			break; \
+		a[i] = a[c]; \
+	} \
+	a[i] = t; \
+} \
+storage void \
+name##_heapify(type *a, size_t count) \
+{ \
+	for (size_t i = count / 2; i-- > 0; ) \
+		name##_sift(a, count, i); \
+} \
+/* sorts a max-heap in place */ \
+storage void \
+name##_heapsort(type *a, size_t count) \
+{ \
+	for (; count > 1; ) { \
+		name##_swap(&a[0], &a[--count]); \
+		name##_sift(a, count, 0); \
+	} \
+} \
+storage void \
+name##_heap_select(type *a, size_t count, size_t k) \
+{ \
+	name##_heapify(a, k + 1); \
+	for (size_t i = k + 1; i < count; i++) \
+		if (less(a[i], a[0])) { \
+			name##_swap(&a[i], &a[0]); \
+			name##_sift(a, k + 1, 0); \
+		} \
+	name##_swap(&a[0], &a[k]); \
+} \
+storage void \
+name##_median3(type *a, type *b, type *c) \
+{ \
+	if (less(*b, *a)) name##_swap(a, b); \
+	if (less(*c, *b)) name##_swap(b, c); \
+	if (less(*b, *a)) name##_swap(a, b); \
+} \
+storage void \
+name##_nth(type *a, size_t count, size_t k) \
+{ \
+	size_t lo = 0, hi = count; \
+	int depth = 0; \
+	for (size_t n = count; n > 1; n >>= 1) \
+		depth += 2; \
+	if (k >= count) \
+		return; \
+	while (hi - lo > SELECT_INSERT) { \
+		size_t n = hi - lo, mid = lo + n / 2, i = lo, j = hi; \
+		if (depth-- == 0) { \
+			name##_heap_select(a + lo, n, k - lo); \
+			return; \
+		} \
+		if (n > SELECT_NINTHER) { \
+			size_t s = n / 8; \
+			name##_median3(&a[lo], &a[lo + s], &a[lo + 2 * s]); \
+			name##_median3(&a[mid - s], &a[mid], &a[mid + s]); \
+			name##_median3(&a[hi - 1 - 2 * s], &a[hi - 1 - s], &a[hi - 1]); \
+			name##_median3(&a[lo + s], &a[mid], &a[hi - 1 - s]); \
+		} else { \
+			name##_median3(&a[lo], &a[mid], &a[hi - 1]); \
+		} \
+		name##_swap(&a[lo], &a[mid]); \
+		type pivot = a[lo]; \
+		for (;;) { \
+			do i++; while (i < hi && less(a[i], pivot)); \
+			do j--; while (less(pivot, a[j])); \
+			if (i >= j) \
+				break; \
+			name##_swap(&a[i], &a[j]); \
+		} \
+		name##_swap(&a[lo], &a[j]); \
+		if (k == j) \
+			return; \
+		if (k < j) \
+			hi = j; \
+		else \
+			lo = j + 1; \
+	} \
+	name##_insert(a + lo, hi - lo); \
+} \
+storage void \
+name##_partial(type *a, size_t count, size_t k) \
+{ \
+	if (k < count) \
+		name##_nth(a, count, k); \
+	else \
+		k = count; \
+	name##_heapify(a, k); \
+	name##_heapsort(a, k); \
+} \
+storage int \
+name##_topk_push(type *heap, size_t *len, size_t k, type item) \
+{ \
+	if (*len < k) { \
+		size_t i = (*len)++; \
+		for (; i && less(heap[(i - 1) / 2], item); i = (i - 1) / 2) \
+			heap[i] = heap[(i - 1) / 2]; \
+		heap[i] = item; \
+		return 1; \
+	} \
+	if (!k || !less(item, heap[0])) \
+		return 0; \
+	heap[0] = item; \
+	name##_sift(heap, k, 0); \
+	return 1; \
+} \
+storage void \
+name##_topk_sort(type *heap, size_t len) \
+{ \
+	name##_heapsort(heap, len); \
+}
+
+#define DEFINE_SELECT(name, type, less) \
+	__DEFINE_SELECT(static __attribute__((unused)), name, type, less)
+
+#endif
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <sys/compiler.h>
 #include <sys/cpu.h>
 #include <sys/types.h>
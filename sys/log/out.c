@@ -45,6 +45,7 @@
  *	 04-29 22:43:20.244 1000  1000               example:  Hi 
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <fcntl.h>
 #include <sys/stat.h>
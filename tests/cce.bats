@@ -6,3 +6,8 @@ load support/helper
   run ./obj/tools/tester
   assert_success
 }
+
+@test "art on an unaligned mm_pool" {
+  run ./obj/tools/test-art 20000
+  assert_success
+}
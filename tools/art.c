@@ -0,0 +1,193 @@
+/*
+ * Adaptive radix tree benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/art.h>
+#include <bsd/rb.h>
+#include <bsd/hash/table.h>
+#include <bsd/hash/fn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Compares struct art with the red-black tree from <bsd/rb.h> using a 
+ * string comparator and with the hash table from <bsd/hash/table.h> on 
+ * URL keys sharing long prefixes: inserts, lookups of present keys and 
+ * prefix scans of one host.
+ *
+ * usage: art [keys]
+ */
+
+struct item {
+	RB_ENTRY(item) entry;
+	struct qnode hnode;
+	const char *key;
+	size_t len;
+};
+
+static int
+item_cmp(struct item *a, struct item *b)
+{
+	return strcmp(a->key, b->key);
+}
+
+RB_HEAD(item_tree, item);
+RB_GENERATE(item_tree, item, entry, item_cmp)
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+count_key(void *ctx, const u8 *key, size_t len, void *val)
+{
+	(void)key; (void)len; (void)val;
+	(*(size_t *)ctx)++;
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 1000000;
+	size_t lookups = count, scans = 1000, found = 0, scanned = 0;
+	struct item *items = calloc(count, sizeof(*items));
+	char *keys = malloc(count * 96);
+	unsigned int bits = 1;
+	u64 x = 88172645463325252ULL;
+	struct item_tree rb = RB_INITIALIZER(&rb);
+	struct art art;
+	double t;
+
+	while ((1ULL << bits) < count)
+		bits++;
+	struct tailq *table = malloc(sizeof(struct tailq) << bits);
+	hash_init_table(table, bits);
+
+	for (size_t i = 0; i < count; i++) {
+		char *key = keys + i * 96;
+		u64 r = rnd(&x);
+		items[i].len = snprintf(key, 96, 
+		        "https://www.host%03u.example.com/catalog/%u/%u/item%zu.html",
+		        (unsigned)(r % 1000), (unsigned)(r >> 10) % 16, 
+		        (unsigned)(r >> 20) % 256, i);
+		items[i].key = key;
+	}
+
+	t = now();
+	for (size_t i = 0; i < count; i++)
+		RB_INSERT(item_tree, &rb, &items[i]);
+	printf("insert  rb    %8.1f ns/key\n", (now() - t) * 1e9 / count);
+
+	t = now();
+	for (size_t i = 0; i < count; i++) {
+		u64 hash = hash_buffer((const u8 *)items[i].key, items[i].len);
+		hash_add(table, &items[i].hnode, hash & ((1ULL << bits) - 1));
+	}
+	printf("insert  hash  %8.1f ns/key\n", (now() - t) * 1e9 / count);
+
+	art_init(&art, mm_libc());
+	t = now();
+	for (size_t i = 0; i < count; i++)
+		art_insert(&art, items[i].key, items[i].len, &items[i]);
+	printf("insert  art   %8.1f ns/key\n", (now() - t) * 1e9 / count);
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		struct item key = { .key = items[rnd(&x) % count].key };
+		found += RB_FIND(item_tree, &rb, &key) != NULL;
+	}
+	printf("find    rb    %8.1f ns/key\n", (now() - t) * 1e9 / lookups);
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		struct item *key = &items[rnd(&x) % count];
+		u64 hash = hash_buffer((const u8 *)key->key, key->len);
+		hash_for_each(table, hash & ((1ULL << bits) - 1), it, struct item, hnode)
+			if (it->len == key->len && !memcmp(it->key, key->key, key->len)) {
+				found++;
+				break;
+			}
+	}
+	printf("find    hash  %8.1f ns/key\n", (now() - t) * 1e9 / lookups);
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		struct item *key = &items[rnd(&x) % count];
+		void *val;
+		found += art_find(&art, key->key, key->len, &val);
+	}
+	printf("find    art   %8.1f ns/key\n", (now() - t) * 1e9 / lookups);
+
+	t = now();
+	for (size_t i = 0; i < scans; i++) {
+		char prefix[64];
+		int len = snprintf(prefix, sizeof(prefix), 
+		                   "https://www.host%03u.example.com/",
+		                   (unsigned)(rnd(&x) % 1000));
+		struct item key = { .key = prefix }, *it;
+		for (it = RB_NFIND(item_tree, &rb, &key); 
+		     it && !strncmp(it->key, prefix, len); 
+		     it = RB_NEXT(item_tree, &rb, it))
+			scanned++;
+	}
+	printf("prefix  rb    %8.1f us/scan\n", (now() - t) * 1e6 / scans);
+
+	t = now();
+	for (size_t i = 0; i < scans; i++) {
+		char prefix[64];
+		int len = snprintf(prefix, sizeof(prefix), 
+		                   "https://www.host%03u.example.com/",
+		                   (unsigned)(rnd(&x) % 1000));
+		art_walk_prefix(&art, prefix, len, count_key, &scanned);
+	}
+	printf("prefix  art   %8.1f us/scan\n", (now() - t) * 1e6 / scans);
+
+	printf("keys %zu found %zu scanned %zu\n", count, found, scanned);
+	art_fini(&art);
+	free(table);
+	free(keys);
+	free(items);
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Bloom and cuckoo filter benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/fn.h>
+#include <bsd/hash/bloom.h>
+#include <bsd/hash/cuckoo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Compares the blocked Bloom filter with the cuckoo filter for a few target
+ * false positive probabilities: inserts, queries of present keys and 
+ * queries of absent keys, which also give the measured false positive 
+ * rate.
+ *
+ * usage: bloom [keys]
+ */
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	u64 count = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	static const double targets[] = { 0.01, 0.001, 0.0001 };
+	u64 found, failed;
+	double t;
+
+	printf("filter    target    bits/key  insert     present    absent     "
+	       "fpp\n");
+	for (unsigned int i = 0; i < array_size(targets); i++) {
+		struct bloom bloom;
+		double add, hit, miss;
+
+		if (bloom_init(&bloom, mm_libc(), count, targets[i]))
+			return 1;
+
+		t = now();
+		for (u64 x = 0; x < count; x++)
+			bloom_add(&bloom, hash_u64(x, 64));
+		add = now() - t;
+
+		t = now(), found = 0;
+		for (u64 x = 0; x < count; x++)
+			found += bloom_test(&bloom, hash_u64(x, 64));
+		hit = now() - t;
+		if (found != count)
+			printf("bloom: %llu false negatives\n", 
+			       (unsigned long long)(count - found));
+
+		t = now(), found = 0;
+		for (u64 x = count; x < 2 * count; x++)
+			found += bloom_test(&bloom, hash_u64(x, 64));
+		miss = now() - t;
+
+		printf("bloom     %-9g %8.1f  %5.1f ns   %5.1f ns   %5.1f ns   "
+		       "%g\n",
+		       targets[i], 8.0 * bloom_size(&bloom) / count, 
+		       add * 1e9 / count, hit * 1e9 / count, miss * 1e9 / count,
+		       (double)found / count);
+		bloom_fini(&bloom);
+	}
+
+	for (unsigned int i = 0; i < array_size(targets); i++) {
+		struct cuckoo cuckoo;
+		double add, hit, miss;
+
+		if (cuckoo_init(&cuckoo, mm_libc(), count, targets[i]))
+			return 1;
+
+		t = now(), failed = 0;
+		for (u64 x = 0; x < count; x++)
+			failed += cuckoo_add(&cuckoo, hash_u64(x, 64)) != 0;
+		add = now() - t;
+		if (failed)
+			printf("cuckoo: %llu inserts failed\n", 
+			       (unsigned long long)failed);
+
+		t = now(), found = 0;
+		for (u64 x = 0; x < count; x++)
+			found += cuckoo_test(&cuckoo, hash_u64(x, 64));
+		hit = now() - t;
+		if (found != count)
+			printf("cuckoo: %llu false negatives\n", 
+			       (unsigned long long)(count - found));
+
+		t = now(), found = 0;
+		for (u64 x = count; x < 2 * count; x++)
+			found += cuckoo_test(&cuckoo, hash_u64(x, 64));
+		miss = now() - t;
+
+		printf("cuckoo    %-9g %8.1f  %5.1f ns   %5.1f ns   %5.1f ns   "
+		       "%g\n",
+		       targets[i], 8.0 * cuckoo_size(&cuckoo) / count, 
+		       add * 1e9 / count, hit * 1e9 / count, miss * 1e9 / count,
+		       (double)found / count);
+		cuckoo_fini(&cuckoo);
+	}
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * B+tree benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/btree.h>
+#include <bsd/rb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Compares struct btree with the red-black tree from <bsd/rb.h> on random 
+ * u64 keys: inserts, point lookups of present keys and range scans of 100 
+ * keys from a random start.
+ *
+ * usage: btree [keys]
+ */
+
+struct item {
+	RB_ENTRY(item) entry;
+	u64 key;
+};
+
+static int
+item_cmp(struct item *a, struct item *b)
+{
+	return a->key < b->key ? -1: a->key > b->key;
+}
+
+RB_HEAD(item_tree, item);
+RB_GENERATE(item_tree, item, entry, item_cmp)
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return x < y ? -1: x > y;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	size_t lookups = count, scans = 100000, span = 100;
+	struct item *items = malloc(count * sizeof(*items));
+	u64 *keys = malloc(count * sizeof(u64)), x = 88172645463325252ULL, sum = 0;
+	struct item_tree rb = RB_INITIALIZER(&rb);
+	struct btree bt;
+	double t;
+
+	for (size_t i = 0; i < count; i++)
+		keys[i] = items[i].key = rnd(&x);
+
+	t = now();
+	for (size_t i = 0; i < count; i++)
+		RB_INSERT(item_tree, &rb, &items[i]);
+	printf("insert  rb    %8.1f ns/key\n", (now() - t) * 1e9 / count);
+
+	btree_init(&bt, mm_libc());
+	t = now();
+	for (size_t i = 0; i < count; i++)
+		btree_insert(&bt, keys[i], &items[i]);
+	printf("insert  btree %8.1f ns/key\n", (now() - t) * 1e9 / count);
+	btree_fini(&bt);
+
+	u64 *sorted = malloc(count * sizeof(u64));
+	for (size_t i = 0; i < count; i++)
+		sorted[i] = keys[i];
+	qsort(sorted, count, sizeof(u64), u64_cmp);
+	t = now();
+	btree_load(&bt, sorted, NULL, count);
+	printf("load    btree %8.1f ns/key\n", (now() - t) * 1e9 / count);
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		struct item key = { .key = keys[rnd(&x) % count] };
+		sum += (uintptr_t)RB_FIND(item_tree, &rb, &key);
+	}
+	printf("find    rb    %8.1f ns/key\n", (now() - t) * 1e9 / lookups);
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		void *val;
+		sum += btree_find(&bt, keys[rnd(&x) % count], &val);
+	}
+	printf("find    btree %8.1f ns/key\n", (now() - t) * 1e9 / lookups);
+
+	t = now();
+	for (size_t i = 0; i < scans; i++) {
+		struct item key = { .key = rnd(&x) }, *it;
+		it = RB_NFIND(item_tree, &rb, &key);
+		for (size_t n = 0; it && n < span; n++, it = RB_NEXT(item_tree, &rb, it))
+			sum += it->key;
+	}
+	printf("scan    rb    %8.1f ns/key\n", (now() - t) * 1e9 / (scans * span));
+
+	t = now();
+	for (size_t i = 0; i < scans; i++) {
+		struct btree_iter it;
+		size_t n = 0;
+		btree_walk(&bt, &it, rnd(&x)) {
+			if (n++ == span)
+				break;
+			sum += btree_key(&it);
+		}
+	}
+	printf("scan    btree %8.1f ns/key\n", (now() - t) * 1e9 / (scans * span));
+
+	printf("keys %zu height %u checksum %llx\n", count, bt.height, 
+	       (unsigned long long)sum);
+	btree_fini(&bt);
+	free(sorted);
+	free(keys);
+	free(items);
+	return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Bounded cache benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/fn.h>
+#include <bsd/hash/cache.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+/*
+ * Replays Zipfian request traces through struct cache with CACHE_LRU and 
+ * CACHE_S3FIFO: every miss inserts the key, evicted items go back to a 
+ * free list. Traces are generated up front for a few skews, once plain and
+ * once with 20% of the requests being one-time sequential scans, and run 
+ * for caches of 1% and 10% of the key space.
+ *
+ * usage: cache [requests] [keys]
+ */
+
+struct item {
+	struct cache_node node;
+	u64 key;
+	struct item *next;
+};
+
+static struct item *free_items;
+
+static int
+item_eq(struct cache_node *node, const void *key)
+{
+	struct item *item = __container_of(node, struct item, node);
+	return item->key == *(const u64 *)key;
+}
+
+static void
+item_evict(struct cache *cache, struct cache_node *node)
+{
+	struct item *item = __container_of(node, struct item, node);
+	item->next = free_items;
+	free_items = item;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* keys 0..count-1 with probability proportional to 1 / (rank + 1)^alpha */
+static void
+zipf_trace(u64 *trace, size_t requests, u64 count, double alpha, int scans)
+{
+	double *cdf = malloc(count * sizeof(double)), sum = 0;
+	u64 scan = count;
+
+	for (u64 i = 0; i < count; i++)
+		cdf[i] = sum += 1.0 / pow((double)(i + 1), alpha);
+	for (size_t i = 0; i < requests; i++) {
+		if (scans && i % 100000 < 20000) {
+			trace[i] = scan++;
+			continue;
+		}
+		double u = drand48() * sum;
+		u64 lo = 0, hi = count - 1;
+		while (lo < hi) {
+			u64 mid = (lo + hi) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		/* scatter the ranks so that hot keys are not neighbours */
+		trace[i] = hash_u64(lo, 64);
+	}
+	free(cdf);
+}
+
+static void
+replay(const u64 *trace, size_t requests, u64 capacity, 
+       enum cache_policy policy, struct item *items)
+{
+	struct cache cache;
+	double t;
+
+	free_items = NULL;
+	for (u64 i = 0; i <= capacity; i++)
+		item_evict(NULL, &items[i].node);
+
+	cache_init(&cache, mm_libc(), capacity, policy, item_eq, item_evict);
+	t = now();
+	for (size_t i = 0; i < requests; i++) {
+		u64 key = trace[i], hash = hash_u64(key, 64);
+		if (cache_get(&cache, hash, &key))
+			continue;
+		struct item *item = free_items;
+		free_items = item->next;
+		item->key = key;
+		cache_put(&cache, &item->node, hash);
+	}
+	t = now() - t;
+	printf("  %-7s %8.4f %8.1f ns/request\n",
+	       policy == CACHE_LRU ? "lru": "s3fifo", cache_hit_ratio(&cache), 
+	       t * 1e9 / requests);
+	cache_fini(&cache);
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t requests = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	u64 count = argc > 2 ? strtoull(argv[2], NULL, 10): 1000000;
+	static const double skews[] = { 0.7, 0.9, 1.1 };
+	u64 *trace = malloc(requests * sizeof(u64));
+	struct item *items = malloc((count / 10 + 1) * sizeof(*items));
+
+	srand48(1);
+	for (unsigned int i = 0; i < array_size(skews); i++) {
+		for (int scans = 0; scans < 2; scans++) {
+			zipf_trace(trace, requests, count, skews[i], scans);
+			u64 capacity = __max(count / 100, 1);
+			for (; capacity <= count / 10; capacity *= 10) {
+				printf("zipf %.1f%s keys %llu capacity %llu\n", 
+				       skews[i], scans ? " + scans": "", 
+				       (unsigned long long)count,
+				       (unsigned long long)capacity);
+				replay(trace, requests, capacity, CACHE_LRU, 
+				       items);
+				replay(trace, requests, capacity, CACHE_S3FIFO, 
+				       items);
+			}
+		}
+	}
+
+	free(items);
+	free(trace);
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Consistent hashing benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/fn.h>
+#include <bsd/hash/consistent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Routes random keys to 4 .. 1024 nodes with modulo, hash_jump(), 
+ * hash_rendezvous() and hash_rendezvous_weighted(): lookup cost per key 
+ * and the fraction of keys which move to another node when one node is 
+ * added. The ideal is 1 / (n + 1), or the share of the new node in the 
+ * total weight for weights cycling 1 to 4. Ends with the highest node load of 
+ * struct hash_bounded for a key set with only 1000 distinct keys.
+ *
+ * usage: consistent [keys]
+ */
+
+#define NODES 1025
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	u64 count = argc > 1 ? strtoull(argv[1], NULL, 10): 200000, sum = 0;
+	static u32 seed[NODES];
+	static float weight[NODES];
+	struct hash_bounded bounded;
+	double t;
+
+	for (u32 i = 0; i < NODES; i++) {
+		seed[i] = hash_u32(i + 1, 32);
+		weight[i] = (float)(i % 4 + 1);
+	}
+
+	printf("nodes  ns/key: mod    jump   rdv    weighted   "
+	       "moved: mod    jump    rdv     weighted  ideal   weighted\n");
+	for (u32 n = 4; n < NODES; n *= 4) {
+		double ns[4], total = 0;
+		u64 moved[4] = {0};
+
+		for (u32 i = 0; i <= n; i++)
+			total += weight[i];
+
+		t = now();
+		for (u64 i = 0; i < count; i++)
+			sum += hash_u64(i, 64) % n;
+		ns[0] = now() - t;
+
+		t = now();
+		for (u64 i = 0; i < count; i++)
+			sum += hash_jump(hash_u64(i, 64), n);
+		ns[1] = now() - t;
+
+		t = now();
+		for (u64 i = 0; i < count; i++)
+			sum += hash_rendezvous(hash_u64(i, 64), seed, n);
+		ns[2] = now() - t;
+
+		t = now();
+		for (u64 i = 0; i < count; i++)
+			sum += hash_rendezvous_weighted(hash_u64(i, 64), seed, 
+			                                weight, n);
+		ns[3] = now() - t;
+
+		for (u64 i = 0; i < count; i++) {
+			u64 key = hash_u64(i, 64);
+			moved[0] += key % n != key % (n + 1);
+			moved[1] += hash_jump(key, n) != hash_jump(key, n + 1);
+			moved[2] += hash_rendezvous(key, seed, n) != 
+			            hash_rendezvous(key, seed, n + 1);
+			const float *w = weight;
+			u32 a = hash_rendezvous_weighted(key, seed, w, n);
+			u32 b = hash_rendezvous_weighted(key, seed, w, n + 1);
+			moved[3] += a != b;
+		}
+
+		printf("%5u  %11.1f %6.1f %6.1f %6.1f   %12.3f %7.4f %7.4f "
+		       "%7.4f   %7.4f %7.4f\n", n, 
+		       ns[0] * 1e9 / count, ns[1] * 1e9 / count, 
+		       ns[2] * 1e9 / count, ns[3] * 1e9 / count,
+		       (double)moved[0] / count, (double)moved[1] / count,
+		       (double)moved[2] / count, (double)moved[3] / count,
+		       1.0 / (n + 1), weight[n] / total);
+	}
+
+	hash_bounded_init(&bounded, mm_libc(), 100, 0.1);
+	for (u64 i = 0; i < count; i++)
+		hash_bounded_add(&bounded, hash_u64(i, 64) % 1000);
+	u64 max = 0;
+	for (u32 i = 0; i < bounded.count; i++)
+		max = __max(max, bounded.load[i]);
+	printf("bounded eps 0.1 nodes 100 max load %llu average %llu\n",
+	       (unsigned long long)max, (unsigned long long)(count / 100));
+	hash_bounded_fini(&bounded);
+
+	printf("checksum %llx\n", (unsigned long long)sum);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * External sort benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/sort/external.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/*
+ * Writes @records random records of @size bytes with a 16-byte key in front,
+ * sorts them with sort_external() under @memory bytes and reports MB/s and 
+ * the peak RSS of the process.
+ *
+ * usage: extsort [records] [size] [memory MiB] [tmpdir]
+ */
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t records = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	size_t size = argc > 2 ? strtoull(argv[2], NULL, 10): 100;
+	size_t memory = (argc > 3 ? strtoull(argv[3], NULL, 10): 64) << 20;
+	const char *tmpdir = argc > 4 ? argv[4]: "/tmp";
+	char path[2][256];
+
+	size = __max(size, 16);
+	snprintf(path[0], sizeof(path[0]), "%s/extsort.in.XXXXXX", tmpdir);
+	snprintf(path[1], sizeof(path[1]), "%s/extsort.out.XXXXXX", tmpdir);
+	int in = mkstemp(path[0]), out = mkstemp(path[1]);
+	if (in == -1 || out == -1) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path[0]);
+	unlink(path[1]);
+
+	byte *buf = malloc(SORT_EXTERNAL_BLOCK / size * size);
+	u64 x = 88172645463325252ULL;
+	for (size_t done = 0; done < records; ) {
+		size_t n = __min(records - done, SORT_EXTERNAL_BLOCK / size);
+		for (size_t i = 0; i < n * size; i += 8) {
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+			memcpy(buf + i, &x, __min((size_t)8, n * size - i));
+		}
+		if (write(in, buf, n * size) != (ssize_t)(n * size)) {
+			perror("write");
+			return 1;
+		}
+		done += n;
+	}
+	free(buf);
+	lseek(in, 0, SEEK_SET);
+
+	struct sort_external_stat stat;
+	double t = now();
+	if (sort_external(in, out, size, 0, 16, memory, tmpdir, mm_libc(), &stat)) {
+		perror("sort_external");
+		return 1;
+	}
+	t = now() - t;
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	double mb = (double)records * size / (1 << 20);
+	printf("records %llu size %zu memory %zu MiB\n", 
+	       (unsigned long long)records, size, memory >> 20);
+	printf("runs %llu passes %llu read %.1f MiB written %.1f MiB\n",
+	       (unsigned long long)stat.runs, (unsigned long long)stat.passes,
+	       stat.bytes_read / 1048576.0, stat.bytes_written / 1048576.0);
+	printf("%.2f s %.1f MB/s peak rss %ld MiB\n", t, mb / t, ru.ru_maxrss >> 10);
+
+	close(in);
+	close(out);
+	return 0;
+}
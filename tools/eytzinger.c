@@ -0,0 +1,166 @@
+/*
+ * Eytzinger search benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/eytzinger.h>
+#include <bsd/rb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Compares the lower bound of random u64 keys over count distinct sorted 
+ * keys: RB_NFIND on a red-black tree, a plain binary search over the 
+ * sorted array and the branchless search over the Eytzinger layout built 
+ * by draining the tree.
+ *
+ * usage: eytzinger [keys]
+ */
+
+struct item {
+	RB_ENTRY(item) entry;
+	u64 key;
+};
+
+static int
+item_cmp(struct item *a, struct item *b)
+{
+	return a->key < b->key ? -1: a->key > b->key;
+}
+
+RB_HEAD(item_tree, item);
+RB_GENERATE(item_tree, item, entry, item_cmp)
+
+DEFINE_EYTZINGER(u64_eyt, u64, eytzinger_less)
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return x < y ? -1: x > y;
+}
+
+static size_t
+lower_bound(const u64 *a, size_t count, u64 key)
+{
+	size_t lo = 0, hi = count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (a[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 1000000;
+	size_t lookups = 4000000, n = 0;
+	struct item *items = calloc(count, sizeof(*items));
+	u64 *sorted = malloc(count * sizeof(u64));
+	u64 *eyt = aligned_alloc(64, ((count + 1) * sizeof(u64) + 63) & ~63);
+	u64 x = 88172645463325252ULL, seed, sum;
+	struct item_tree rb = RB_INITIALIZER(&rb);
+	struct item *it;
+	double t;
+
+	for (size_t i = 0; i < count; i++) {
+		items[i].key = rnd(&x);
+		if (!RB_INSERT(item_tree, &rb, &items[i]))
+			sorted[n++] = items[i].key;
+	}
+	count = n;
+	qsort(sorted, count, sizeof(u64), u64_cmp);
+
+	/* eyt[0] is what a lower bound past the end reads */
+	eyt[0] = 0;
+	t = now();
+	eytzinger_from_rb(eyt, count, item_tree, &rb, it, it->key);
+	printf("build   rb     %8.1f ms\n", (now() - t) * 1e3);
+
+	for (size_t i = 0; i < 100000; i++) {
+		u64 key = rnd(&x);
+		size_t k = u64_eyt_lower_bound(eyt, count, key);
+		size_t j = lower_bound(sorted, count, key);
+		if (k ? eyt[k] != sorted[j]: j != count) {
+			printf("mismatch for key %llu\n", (unsigned long long)key);
+			return 1;
+		}
+	}
+
+	seed = x, sum = 0, t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		struct item key = { .key = rnd(&x) };
+		it = RB_NFIND(item_tree, &rb, &key);
+		sum += it ? it->key: 0;
+	}
+	printf("nfind   rb     %8.1f ns/key %llx\n", (now() - t) * 1e9 / lookups,
+	       (unsigned long long)sum);
+
+	x = seed, sum = 0, t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		size_t j = lower_bound(sorted, count, rnd(&x));
+		sum += j < count ? sorted[j]: 0;
+	}
+	printf("lower   sorted %8.1f ns/key %llx\n", (now() - t) * 1e9 / lookups,
+	       (unsigned long long)sum);
+
+	x = seed, sum = 0, t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		size_t k = u64_eyt_lower_bound(eyt, count, rnd(&x));
+		sum += eyt[k];
+	}
+	printf("lower   eyt    %8.1f ns/key %llx\n", (now() - t) * 1e9 / lookups,
+	       (unsigned long long)sum);
+
+	printf("keys %zu\n", count);
+	free(eyt);
+	free(sorted);
+	free(items);
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * List merge sort benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/list.h>
+#include <bsd/sort.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Compares merge_sort_natural_asc() with the bottom-up merge_sort_asc() 
+ * from <bsd/sort.h> on lists which are random, nearly sorted (1% and 0.01% 
+ * of the keys swapped), 16 concatenated sorted runs and reverse sorted. 
+ * Every result is checked for order and length.
+ *
+ * usage: listsort [count]
+ */
+
+struct item {
+	struct node node;
+	u64 key;
+};
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+item_cmp(struct node *a, struct node *b)
+{
+	u64 x = __container_of(a, struct item, node)->key;
+	u64 y = __container_of(b, struct item, node)->key;
+	return x < y ? -1: x > y;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return x < y ? -1: x > y;
+}
+
+/* links the items in array order */
+static void
+build(struct list *list, struct item *items, u64 *keys, size_t count)
+{
+	list_init(list);
+	for (size_t i = count; i-- > 0; ) {
+		items[i].key = keys[i];
+		list_add(list, &items[i].node);
+	}
+}
+
+static int
+check(struct list *list, size_t count)
+{
+	struct node *prev = NULL;
+	size_t n = 0;
+	for (struct node *it = list_first(list); it; it = list_next(list, it)) {
+		if (it->prev != (prev ? prev: &list->head))
+			return 0;
+		if (prev && item_cmp(prev, it) > 0)
+			return 0;
+		prev = it;
+		n++;
+	}
+	return n == count;
+}
+
+static void
+bench(const char *name, struct item *items, u64 *keys, size_t count)
+{
+	DECLARE_LIST(list);
+	double t, bottom, natural;
+	int ok;
+
+	build(&list, items, keys, count);
+	t = now();
+	merge_sort_asc(&list, list, item_cmp);
+	bottom = now() - t;
+	ok = check(&list, count);
+
+	build(&list, items, keys, count);
+	t = now();
+	merge_sort_natural_asc(&list, list, item_cmp);
+	natural = now() - t;
+	ok = ok && check(&list, count);
+
+	printf("%-14s bottom-up %7.1f ns/node  natural %7.1f ns/node  "
+	       "%5.1fx %s\n", name, bottom * 1e9 / count, natural * 1e9 / count,
+	       bottom / natural, ok ? "ok": "MISMATCH");
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 1000000;
+	struct item *items = malloc(count * sizeof(*items));
+	u64 *keys = malloc(count * sizeof(u64)), x = 88172645463325252ULL;
+
+	for (size_t i = 0; i < count; i++)
+		keys[i] = rnd(&x);
+	bench("random", items, keys, count);
+
+	for (size_t ratio = 100; ratio <= 10000; ratio *= 100) {
+		qsort(keys, count, sizeof(u64), u64_cmp);
+		for (size_t i = 0; i < count / ratio; i++) {
+			size_t a = rnd(&x) % count, b = rnd(&x) % count;
+			u64 k = keys[a]; keys[a] = keys[b]; keys[b] = k;
+		}
+		const char *name = ratio == 100 ? "1% swapped": "0.01% swapped";
+		bench(name, items, keys, count);
+	}
+
+	for (size_t i = 0; i < count; i++)
+		keys[i] = rnd(&x);
+	for (size_t i = 0; i < 16; i++) {
+		size_t from = count * i / 16, to = count * (i + 1) / 16;
+		qsort(keys + from, to - from, sizeof(u64), u64_cmp);
+	}
+	bench("16 runs", items, keys, count);
+
+	qsort(keys, count, sizeof(u64), u64_cmp);
+	for (size_t i = 0; i < count / 2; i++) {
+		u64 k = keys[i]; keys[i] = keys[count - 1 - i]; 
+		keys[count - 1 - i] = k;
+	}
+	bench("reversed", items, keys, count);
+
+	free(keys);
+	free(items);
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Batched hash table lookup benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/hash/fn.h>
+#include <bsd/hash/table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Looks up random keys, half of them present, in a hash table from 
+ * <bsd/hash/table.h> with about one item per bucket, one key at a time with
+ * hash_u64() and hash_for_each() and then in batches of 1 to 64 keys with
+ * hash_u64_many() and hash_lookup_many(). The table is sized well above the
+ * last level cache by default, so the batches can overlap the misses.
+ *
+ * usage: lookup [bits] [lookups]
+ */
+
+struct item {
+	struct qnode node;
+	u64 key;
+};
+
+#define item_eq(it, k) ((it)->key == (k))
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned int bits = argc > 1 ? strtoul(argv[1], NULL, 10): 22;
+	size_t lookups = argc > 2 ? strtoull(argv[2], NULL, 10): 4000000;
+	size_t count = (size_t)1 << bits, found = 0;
+	struct tailq *table = malloc(count * sizeof(*table));
+	struct item *items = malloc(count * sizeof(*items));
+	u64 *keys = malloc(lookups * sizeof(u64)), x = 88172645463325252ULL;
+	double t;
+
+	hash_init_table(table, bits);
+	for (size_t i = 0; i < count; i++) {
+		items[i].key = rnd(&x);
+		hash_add(table, &items[i].node, hash_u64(items[i].key, bits));
+	}
+	for (size_t i = 0; i < lookups; i++)
+		keys[i] = i & 1 ? rnd(&x): items[rnd(&x) % count].key;
+
+	t = now();
+	for (size_t i = 0; i < lookups; i++) {
+		u64 hash = hash_u64(keys[i], bits);
+		hash_for_each(table, hash, it, struct item, node)
+			if (item_eq(it, keys[i])) {
+				found++;
+				break;
+			}
+	}
+	printf("serial   %6.1f ns/key found %zu\n", 
+	       (now() - t) * 1e9 / lookups, found);
+
+	for (unsigned int batch = 1; batch <= 64; batch *= 2) {
+		struct item *result[64];
+		u64 hashes[64];
+		size_t n = lookups / batch * batch;
+		found = 0;
+		t = now();
+		for (size_t i = 0; i < n; i += batch) {
+			hash_u64_many(keys + i, hashes, batch, bits);
+			hash_lookup_many(table, hashes, batch, keys + i, 
+			                 result, struct item, node, item_eq);
+			for (unsigned int j = 0; j < batch; j++)
+				found += result[j] != NULL;
+		}
+		printf("batch %2u %6.1f ns/key found %zu\n", batch, 
+		       (now() - t) * 1e9 / n, found);
+	}
+
+	free(keys);
+	free(items);
+	free(table);
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Pattern-defeating quicksort benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <bsd/sort/pdq.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Compares the pdq sorts from <bsd/sort/pdq.h>, the C macro and the C++ 
+ * template, with qsort() and std::sort on u64 keys which are random, 
+ * sorted, reverse sorted and drawn from 16 distinct values. Every result 
+ * is checked against the std::sort order.
+ *
+ * usage: pdq [count]
+ */
+
+#define u64_less(a, b) ((a) < (b))
+DEFINE_PDQ_SORT(u64_sort, uint64_t, u64_less)
+
+static uint64_t
+rnd(uint64_t *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1: x > y;
+}
+
+static void
+bench(const char *name, const std::vector<uint64_t> &input)
+{
+	size_t count = input.size(), bytes = count * sizeof(uint64_t);
+	std::vector<uint64_t> ref(input), a(input), b(input), c(input);
+	double t, qs, std, macro, tmpl;
+
+	t = now();
+	qsort(a.data(), count, sizeof(uint64_t), u64_cmp);
+	qs = now() - t;
+
+	t = now();
+	std::sort(ref.begin(), ref.end());
+	std = now() - t;
+
+	t = now();
+	u64_sort(b.data(), count);
+	macro = now() - t;
+
+	t = now();
+	pdq_sort(c.data(), count);
+	tmpl = now() - t;
+
+	int ok = !memcmp(a.data(), ref.data(), bytes) && 
+	         !memcmp(b.data(), ref.data(), bytes) &&
+	         !memcmp(c.data(), ref.data(), bytes);
+
+	printf("%-10s qsort %6.1f  std::sort %6.1f  pdq C %6.1f  "
+	       "pdq C++ %6.1f ns/key %s\n", name, qs * 1e9 / count, 
+	       std * 1e9 / count, macro * 1e9 / count, tmpl * 1e9 / count, 
+	       ok ? "ok": "MISMATCH");
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	std::vector<uint64_t> v(count);
+	uint64_t x = 88172645463325252ULL;
+
+	for (size_t i = 0; i < count; i++)
+		v[i] = rnd(&x);
+	bench("random", v);
+
+	std::sort(v.begin(), v.end());
+	bench("sorted", v);
+
+	std::reverse(v.begin(), v.end());
+	bench("reversed", v);
+
+	for (size_t i = 0; i < count; i++)
+		v[i] = rnd(&x) % 16;
+	bench("dups 16", v);
+	return 0;
+}
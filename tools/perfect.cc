@@ -0,0 +1,183 @@
+/*
+ * Compile-time perfect hash benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#include <bsd/hash/perfect.h>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/compiler.h>
+#include <bsd/hash/fn.h>
+#include <bsd/hash/table.h>
+
+/*
+ * Compares struct perfect_hash with the intrusive tailq hash table from 
+ * <bsd/hash/table.h> and std::unordered_map on 16, 256 and 4096 keyword 
+ * like keys: lookups of random present keys and of absent keys. The key 
+ * sets are generated at compile time, the perfect hash tables too.
+ *
+ * usage: perfect [lookups]
+ */
+
+/* N distinct keys of 4 to 19 characters, the last 3 encode the index */
+template <size_t N>
+struct words {
+	char buf[N][20];
+	const char *key[N];
+
+	constexpr
+	words()
+	: buf{}, key{}
+	{
+		const char *abc = "abcdefghijklmnopqrstuvwxyz-_";
+		uint64_t x = 88172645463325252ULL;
+		for (size_t i = 0; i < N; i++) {
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+			size_t len = 1 + x % 16, j = 0;
+			for (; j < len; j++)
+				buf[i][j] = abc[(x >> (j * 4)) % 28];
+			buf[i][j++] = 'a' + i / 676;
+			buf[i][j++] = 'a' + i / 26 % 26;
+			buf[i][j++] = 'a' + i % 26;
+			key[i] = buf[i];
+		}
+	}
+};
+
+struct item {
+	struct qnode node;
+	const char *key;
+	size_t len;
+	int id;
+};
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template <size_t N>
+static void
+bench(const words<N> &w, const perfect_hash<N> &ph, size_t lookups)
+{
+	std::unordered_map<std::string, int> map;
+	std::vector<struct item> items(N);
+	std::vector<std::string> hit, miss;
+	unsigned int bits = 1;
+	long sum = 0;
+	double t;
+
+	while ((1U << bits) < N)
+		bits++;
+	std::vector<struct tailq> table(1U << bits);
+	for (auto &bucket: table)
+		bucket.head = NULL;
+
+	for (size_t i = 0; i < N; i++) {
+		struct item *it = &items[i];
+		it->key = w.key[i];
+		it->len = strlen(w.key[i]);
+		it->id = (int)i;
+		u64 hash = hash_buffer((const u8 *)it->key, it->len);
+		hash_add(table.data(), &it->node, hash >> (64 - bits));
+		map[w.key[i]] = (int)i;
+		if (ph.find(w.key[i]) != (int)i) {
+			printf("perfect_hash: key %zu not found\n", i);
+			exit(1);
+		}
+	}
+
+	srand(1);
+	for (size_t i = 0; i < lookups; i++) {
+		hit.push_back(w.key[rand() % N]);
+		/* absent keys, the index part is out of range */
+		miss.push_back(hit.back() + "zz");
+	}
+
+	for (int absent = 0; absent < 2; absent++) {
+		const std::vector<std::string> &keys = absent ? miss: hit;
+		const char *what = absent ? "absent ": "present";
+
+		t = now();
+		for (auto &key: keys)
+			sum += ph.find(key.data(), key.size());
+		printf("%4zu %s perfect   %6.1f ns\n", N, what, 
+		       (now() - t) * 1e9 / lookups);
+
+		t = now();
+		for (auto &key: keys) {
+			const u8 *p = (const u8 *)key.data();
+			u64 hash = hash_buffer(p, key.size());
+			struct qnode *n = table[hash >> (64 - bits)].head;
+			for (; n; n = n->next) {
+				struct item *it;
+				it = __container_of(n, struct item, node);
+				if (it->len == key.size() && 
+				    !memcmp(it->key, key.data(), key.size())) {
+					sum += it->id;
+					break;
+				}
+			}
+		}
+		printf("%4zu %s tailq     %6.1f ns\n", N, what, 
+		       (now() - t) * 1e9 / lookups);
+
+		t = now();
+		for (auto &key: keys) {
+			auto it = map.find(key);
+			sum += it == map.end() ? -1: it->second;
+		}
+		printf("%4zu %s unordered %6.1f ns\n", N, what, 
+		       (now() - t) * 1e9 / lookups);
+	}
+
+	if (sum == 42)
+		printf("\n");
+}
+
+static constexpr words<16> w16;
+static constexpr words<256> w256;
+static constexpr words<4096> w4096;
+static constexpr auto ph16 = perfect_hash_make(w16.key);
+static constexpr auto ph256 = perfect_hash_make(w256.key);
+static constexpr auto ph4096 = perfect_hash_make(w4096.key);
+
+int
+main(int argc, char *argv[])
+{
+	size_t lookups = argc > 1 ? strtoull(argv[1], NULL, 10): 1000000;
+
+	bench(w16, ph16, lookups);
+	bench(w256, ph256, lookups);
+	bench(w4096, ph4096, lookups);
+	return 0;
+}
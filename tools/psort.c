@@ -0,0 +1,138 @@
+/*
+ * Parallel merge sort benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/list.h>
+#include <bsd/sort/parallel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+/*
+ * Sorts lists of 1M, 10M and 100M random nodes, up to @nodes, with 
+ * merge_sort_parallel() on 1, 2, 4, ... threads up to @threads, which 
+ * defaults to the number of online CPUs, and prints the speedup over one 
+ * thread. Every result is checked for order and length.
+ *
+ * usage: psort [nodes] [threads]
+ */
+
+struct item {
+	struct node node;
+	u64 key;
+};
+
+/* splitmix64, the keys are regenerated instead of stored */
+static u64
+key(u64 i)
+{
+	i = (i ^ (i >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	i = (i ^ (i >> 27)) * 0x94d049bb133111ebULL;
+	return i ^ (i >> 31);
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+item_cmp(struct node *a, struct node *b)
+{
+	u64 x = __container_of(a, struct item, node)->key;
+	u64 y = __container_of(b, struct item, node)->key;
+	return x < y ? -1: x > y;
+}
+
+static void
+build(struct list *list, struct item *items, size_t count)
+{
+	list_init(list);
+	for (size_t i = count; i-- > 0; ) {
+		items[i].key = key(i);
+		list_add(list, &items[i].node);
+	}
+}
+
+static int
+check(struct list *list, size_t count)
+{
+	struct node *prev = NULL;
+	size_t n = 0;
+	for (struct node *it = list_first(list); it; it = list_next(list, it)) {
+		if (it->prev != (prev ? prev: &list->head))
+			return 0;
+		if (prev && item_cmp(prev, it) > 0)
+			return 0;
+		prev = it;
+		n++;
+	}
+	return n == count;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t nodes = argc > 1 ? strtoull(argv[1], NULL, 10): 100000000;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int threads = argc > 2 ? strtoul(argv[2], NULL, 10): 
+	                       (unsigned int)__max(cpus, 1);
+	struct item *items = malloc(nodes * sizeof(*items));
+	size_t failed = 0;
+	DECLARE_LIST(list);
+
+	threads = __min(threads, SORT_PARALLEL_MAX_THREADS);
+	printf("%10s %7s %10s %7s\n", "nodes", "threads", "ms", "speedup");
+	for (size_t count = 1000000; count <= nodes; count *= 10) {
+		double single = 0;
+		/* powers of two and the maximum */
+		for (unsigned int t = 1; t <= threads; 
+		     t = t < threads && t * 2 > threads ? threads: t * 2) {
+			build(&list, items, count);
+			double start = now();
+			merge_sort_parallel(&list, item_cmp, t, mm_libc());
+			double ms = (now() - start) * 1e3;
+			int ok = check(&list, count);
+			failed += !ok;
+			if (t == 1)
+				single = ms;
+			printf("%10zu %7u %10.1f %6.2fx %s\n", count, t, ms, 
+			       single / ms, ok ? "ok": "MISMATCH");
+		}
+	}
+
+	free(items);
+	return failed ? 1: 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Radix sort benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/sort/radix.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Compares the radix sorts from <bsd/sort/radix.h> with qsort() on random 
+ * u32, u64, u64 keys below 2^32, doubles, 16-byte records with a u64 key 
+ * and 64-byte records with a 32-byte string key. Every result is checked 
+ * against the qsort() order.
+ *
+ * usage: radix [count]
+ */
+
+struct rec {
+	u64 key;
+	u64 val;
+};
+
+struct str {
+	byte key[32];
+	byte val[32];
+};
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+u32_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+	return x < y ? -1: x > y;
+}
+
+static int
+u64_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return x < y ? -1: x > y;
+}
+
+static int
+double_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1: x > y;
+}
+
+static int
+str_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, sizeof(((struct str *)0)->key));
+}
+
+static void
+report(const char *name, size_t count, double radix, double libc, int ok)
+{
+	printf("%-12s radix %7.1f ns/key  qsort %7.1f ns/key  %5.1fx %s\n", 
+	       name, radix * 1e9 / count, libc * 1e9 / count, libc / radix, 
+	       ok ? "ok": "MISMATCH");
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 10000000;
+	struct mm *mm = mm_libc();
+	u64 x = 88172645463325252ULL;
+	double t, radix, libc;
+
+	u32 *a32 = malloc(count * sizeof(u32));
+	u32 *b32 = malloc(count * sizeof(u32));
+	for (size_t i = 0; i < count; i++)
+		a32[i] = b32[i] = (u32)rnd(&x);
+	t = now();
+	radix_sort_u32(a32, count, mm);
+	radix = now() - t;
+	t = now();
+	qsort(b32, count, sizeof(u32), u32_cmp);
+	libc = now() - t;
+	report("u32", count, radix, libc, !memcmp(a32, b32, count * 4));
+	free(a32);
+	free(b32);
+
+	u64 *a64 = malloc(count * sizeof(u64));
+	u64 *b64 = malloc(count * sizeof(u64));
+	for (unsigned int bits = 64; bits >= 32; bits -= 32) {
+		for (size_t i = 0; i < count; i++)
+			a64[i] = b64[i] = rnd(&x) >> (64 - bits);
+		t = now();
+		radix_sort_u64(a64, count, mm);
+		radix = now() - t;
+		t = now();
+		qsort(b64, count, sizeof(u64), u64_cmp);
+		libc = now() - t;
+		report(bits == 64 ? "u64": "u64 < 2^32", count, radix, libc, 
+		       !memcmp(a64, b64, count * 8));
+	}
+
+	double *ad = (double *)a64, *bd = (double *)b64;
+	for (size_t i = 0; i < count; i++)
+		ad[i] = bd[i] = ((double)rnd(&x) - (double)rnd(&x)) / 1e9;
+	t = now();
+	radix_sort_double(ad, count, mm);
+	radix = now() - t;
+	t = now();
+	qsort(bd, count, sizeof(double), double_cmp);
+	libc = now() - t;
+	report("double", count, radix, libc, !memcmp(ad, bd, count * 8));
+	free(a64);
+	free(b64);
+
+	struct rec *ar = malloc(count * sizeof(*ar));
+	struct rec *br = malloc(count * sizeof(*br));
+	for (size_t i = 0; i < count; i++) {
+		ar[i].key = br[i].key = rnd(&x);
+		ar[i].val = br[i].val = i;
+	}
+	t = now();
+	radix_sort_rec(ar, count, sizeof(*ar), offsetof(struct rec, key), 8, 
+	               mm);
+	radix = now() - t;
+	t = now();
+	qsort(br, count, sizeof(*br), u64_cmp);
+	libc = now() - t;
+	report("rec 16", count, radix, libc, !memcmp(ar, br, count * 16));
+	free(ar);
+	free(br);
+
+	size_t n = count / 4;
+	struct str *as = malloc(n * sizeof(*as)), *bs = malloc(n * sizeof(*bs));
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < sizeof(as[i]); j += 8) {
+			u64 v = rnd(&x);
+			memcpy((byte *)&as[i] + j, &v, 8);
+		}
+		bs[i] = as[i];
+	}
+	t = now();
+	radix_sort_msd(as, n, sizeof(*as), offsetof(struct str, key), 
+	               sizeof(as->key), mm);
+	radix = now() - t;
+	t = now();
+	qsort(bs, n, sizeof(*bs), str_cmp);
+	libc = now() - t;
+	report("msd 32/64", n, radix, libc, !memcmp(as, bs, n * sizeof(*as)));
+	free(as);
+	free(bs);
+	return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * Lock-free skip list benchmark
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <bsd/skiplist.h>
+#include <bsd/rb.h>
+#include <urcu.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Compares the lock-free skip list with the red-black tree from <bsd/rb.h>
+ * behind a pthread rwlock. Every thread runs random lookups, inserts and 
+ * deletes over [0, 2 * keys) for a fixed time, half of the keys are 
+ * present at the start, and the total throughput is reported for 1 to 16 
+ * threads.
+ *
+ * usage: skiplist [keys] [write percent] [seconds]
+ */
+
+#define THREADS_MAX 16
+
+struct item {
+	RB_ENTRY(item) entry;
+	u64 key;
+	void *val;
+};
+
+static int
+item_cmp(struct item *a, struct item *b)
+{
+	return a->key < b->key ? -1: a->key > b->key;
+}
+
+RB_HEAD(item_tree, item);
+RB_GENERATE(item_tree, item, entry, item_cmp)
+
+struct bench {
+	struct skiplist list;
+	struct item_tree rb;
+	pthread_rwlock_t lock;
+	int skiplist;
+	u64 range;
+	unsigned int write;
+	volatile int stop;
+};
+
+struct worker {
+	pthread_t thread;
+	struct bench *bench;
+	u64 seed;
+	u64 ops;
+};
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static void
+rb_insert(struct bench *b, u64 key)
+{
+	struct item *item = malloc(sizeof(*item));
+	item->key = key;
+	item->val = item;
+	pthread_rwlock_wrlock(&b->lock);
+	struct item *old = RB_INSERT(item_tree, &b->rb, item);
+	if (old)
+		old->val = item;
+	pthread_rwlock_unlock(&b->lock);
+	if (old)
+		free(item);
+}
+
+static void
+rb_del(struct bench *b, u64 key)
+{
+	struct item key_item = { .key = key }, *item;
+	pthread_rwlock_wrlock(&b->lock);
+	if ((item = RB_FIND(item_tree, &b->rb, &key_item)))
+		RB_REMOVE(item_tree, &b->rb, item);
+	pthread_rwlock_unlock(&b->lock);
+	free(item);
+}
+
+static int
+rb_find(struct bench *b, u64 key)
+{
+	struct item key_item = { .key = key };
+	pthread_rwlock_rdlock(&b->lock);
+	int found = RB_FIND(item_tree, &b->rb, &key_item) != NULL;
+	pthread_rwlock_unlock(&b->lock);
+	return found;
+}
+
+static void *
+worker(void *arg)
+{
+	struct worker *w = arg;
+	struct bench *b = w->bench;
+	u64 x = w->seed, ops = 0;
+
+	rcu_register_thread();
+	while (!b->stop) {
+		for (unsigned int i = 0; i < 256; i++) {
+			u64 r = rnd(&x), key = r % b->range;
+			unsigned int op = (r >> 40) % 200;
+			if (b->skiplist) {
+				rcu_read_lock();
+				if (op < b->write)
+					skiplist_insert(&b->list, key, w);
+				else if (op < 2 * b->write)
+					skiplist_del(&b->list, key, NULL);
+				else
+					skiplist_find(&b->list, key, NULL);
+				rcu_read_unlock();
+			} else {
+				if (op < b->write)
+					rb_insert(b, key);
+				else if (op < 2 * b->write)
+					rb_del(b, key);
+				else
+					rb_find(b, key);
+			}
+		}
+		ops += 256;
+	}
+	rcu_unregister_thread();
+	w->ops = ops;
+	return NULL;
+}
+
+static double
+run(struct bench *b, unsigned int threads, double seconds)
+{
+	struct worker w[THREADS_MAX];
+	struct timespec ts = { 
+		.tv_sec = (time_t)seconds, 
+		.tv_nsec = (long)((seconds - (time_t)seconds) * 1e9) 
+	};
+	u64 ops = 0;
+
+	b->stop = 0;
+	for (unsigned int i = 0; i < threads; i++) {
+		w[i] = (struct worker) { 
+			.bench = b, .seed = 0x9e3779b97f4a7c15ULL * (i + 1) 
+		};
+		pthread_create(&w[i].thread, NULL, worker, &w[i]);
+	}
+	nanosleep(&ts, NULL);
+	b->stop = 1;
+	for (unsigned int i = 0; i < threads; i++) {
+		pthread_join(w[i].thread, NULL);
+		ops += w[i].ops;
+	}
+	return ops / seconds / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 10): 1000000;
+	unsigned int write = argc > 2 ? atoi(argv[2]): 10;
+	double seconds = argc > 3 ? atof(argv[3]): 1.0;
+	struct bench b = { .range = 2 * count, .write = write };
+	u64 x = 88172645463325252ULL;
+
+	rcu_register_thread();
+	skiplist_init(&b.list);
+	RB_INIT(&b.rb);
+	pthread_rwlock_init(&b.lock, NULL);
+	for (size_t i = 0; i < count; i++) {
+		u64 key = rnd(&x) % b.range;
+		skiplist_insert(&b.list, key, NULL);
+		rb_insert(&b, key);
+	}
+
+	printf("keys %zu, %u%% writes, Mops/s\n", count, write);
+	printf("threads  skiplist  rb+rwlock\n");
+	for (unsigned int threads = 1; threads <= THREADS_MAX; threads *= 2) {
+		b.skiplist = 1;
+		double sl = run(&b, threads, seconds);
+		b.skiplist = 0;
+		double rb = run(&b, threads, seconds);
+		printf("%7u  %8.2f  %9.2f\n", threads, sl, rb);
+	}
+
+	struct item *item, *tmp;
+	RB_FOREACH_SAFE(item, item_tree, &b.rb, tmp) {
+		RB_REMOVE(item_tree, &b.rb, item);
+		free(item);
+	}
+	pthread_rwlock_destroy(&b.lock);
+	skiplist_fini(&b.list);
+	rcu_unregister_thread();
+	return 0;
+}
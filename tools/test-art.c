@@ -0,0 +1,198 @@
+/*
+ * Adaptive radix tree test
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 - 2019                        Daniel Kubec <niel@rtfm.cz>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+
+#define _GNU_SOURCE
+#include <sys/compiler.h>
+#include <sys/cpu.h>
+#include <bsd/list/slink.h>
+#include <mem/alloc.h>
+#include <mem/pool.h>
+#include <bsd/art.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Runs random inserts, deletes and lookups of keys of 0 to 24 bytes with 
+ * shared prefixes on struct art and checks finds, full and prefix walks 
+ * against a reference, once with mm_libc() and once with mm_pool(), which 
+ * does not align, so leaves of odd length are packed at odd addresses 
+ * unless the tree rounds its sizes.
+ *
+ * usage: test-art [ops]
+ */
+
+#define KEYS 4096
+#define KEY_MAX 24
+
+struct key {
+	u8 buf[KEY_MAX];
+	size_t len;
+};
+
+struct walk {
+	struct key *keys;
+	u8 *present;
+	size_t keys_count, count, failed;
+	const struct key *prev;
+};
+
+static u64
+rnd(u64 *x)
+{
+	*x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+	return *x;
+}
+
+static int
+key_cmp(const void *a, const void *b)
+{
+	const struct key *x = a, *y = b;
+	int rv = memcmp(x->buf, y->buf, __min(x->len, y->len));
+	return rv ? rv: (x->len > y->len) - (x->len < y->len);
+}
+
+/* the value of a key is its index + 1, never NULL */
+static void *
+key_val(size_t i)
+{
+	return (void *)(uintptr_t)(i + 1);
+}
+
+static int
+walk_fn(void *ctx, const u8 *key, size_t len, void *val)
+{
+	struct walk *w = ctx;
+	struct key k = { .len = len }, *it;
+
+	if (len > KEY_MAX)
+		return w->failed++, 1;
+	memcpy(k.buf, key, len);
+	it = bsearch(&k, w->keys, w->keys_count, sizeof(k), key_cmp);
+	if (!it || !w->present[it - w->keys] || val != key_val(it - w->keys))
+		w->failed++;
+	if (w->prev && key_cmp(w->prev, it ? it: &k) >= 0)
+		w->failed++;
+	w->prev = it;
+	w->count++;
+	return 0;
+}
+
+static int
+prefixed(const struct key *key, const struct key *prefix)
+{
+	return key->len >= prefix->len && 
+	       !memcmp(key->buf, prefix->buf, prefix->len);
+}
+
+static size_t
+check(struct art *art, struct key *keys, size_t n, u8 *present, u64 *x)
+{
+	struct walk w = { .keys = keys, .keys_count = n, .present = present };
+	size_t failed = 0, count = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		void *val = NULL;
+		int found = art_find(art, keys[i].buf, keys[i].len, &val);
+		if (found != present[i] || (found && val != key_val(i)))
+			failed++;
+		count += present[i];
+	}
+
+	art_walk(art, walk_fn, &w);
+	if (w.count != count || count != art->count)
+		failed++;
+	failed += w.failed;
+
+	struct key prefix = keys[rnd(x) % n];
+	prefix.len = prefix.len ? rnd(x) % prefix.len: 0;
+	count = 0;
+	for (size_t i = 0; i < n; i++)
+		count += present[i] && prefixed(&keys[i], &prefix);
+	w = (struct walk) { .keys = keys, .keys_count = n, .present = present };
+	art_walk_prefix(art, prefix.buf, prefix.len, walk_fn, &w);
+	return failed + w.failed + (w.count != count);
+}
+
+static size_t
+run(const char *name, struct mm *mm, size_t ops)
+{
+	struct key *keys = malloc(KEYS * sizeof(*keys));
+	u8 *present = calloc(KEYS, 1);
+	u64 x = 88172645463325252ULL;
+	size_t failed = 0, n = 0;
+	struct art art;
+
+	/* few distinct bytes so that keys share prefixes and end in nodes */
+	for (size_t i = 0; i < KEYS; i++) {
+		keys[i].len = rnd(&x) % (KEY_MAX + 1);
+		for (size_t j = 0; j < keys[i].len; j++)
+			keys[i].buf[j] = "/abc"[rnd(&x) % 4];
+	}
+	qsort(keys, KEYS, sizeof(*keys), key_cmp);
+	for (size_t i = 0; i < KEYS; i++)
+		if (!n || key_cmp(&keys[n - 1], &keys[i]))
+			keys[n++] = keys[i];
+
+	art_init(&art, mm);
+	for (size_t op = 0; op < ops; op++) {
+		size_t i = rnd(&x) % n;
+		if (rnd(&x) % 3) {
+			int added = art_insert(&art, keys[i].buf, keys[i].len, 
+			                       key_val(i));
+			failed += added == present[i];
+			present[i] = 1;
+		} else {
+			void *val = NULL;
+			int removed = art_del(&art, keys[i].buf, keys[i].len, 
+			                      &val);
+			failed += removed != present[i];
+			failed += removed && val != key_val(i);
+			present[i] = 0;
+		}
+		if (op % 1024 == 0)
+			failed += check(&art, keys, n, present, &x);
+	}
+	failed += check(&art, keys, n, present, &x);
+	art_fini(&art);
+
+	printf("%-8s %zu ops, %zu failed\n", name, ops, failed);
+	free(present);
+	free(keys);
+	return failed;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t ops = argc > 1 ? strtoull(argv[1], NULL, 10): 200000;
+	struct mm_pool *pool = mm_pool_create(CPU_PAGE_SIZE, 0);
+	size_t failed = run("mm_libc", mm_libc(), ops);
+	failed += run("mm_pool", mm_pool(pool), ops);
+	mm_pool_destroy(pool);
+	return failed ? 1: 0;
+}